@@ -0,0 +1,68 @@
+// Preprocessor Directives
+#ifndef ASTEROID_BELT
+#define ASTEROID_BELT
+#pragma once
+
+// Local Headers
+#include "culling.hpp"
+#include "render_queue.hpp"
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Sample Headers
+#include <mesh.hpp>
+#include <shader.hpp>
+
+// Standard Headers
+#include <memory>
+#include <vector>
+
+// A ring of small rocks drawn with instanced calls. Every rock shares one
+// low-polygon mesh; its placement, orientation, size and color live in a
+// static instance buffer built once, and the ring as a whole turns through the
+// model matrix. The buffer is laid out in the leaf order of a bounding volume
+// hierarchy over the rocks, so the clusters inside the view frustum form a
+// few runs of the buffer and each run is one instanced draw.
+class AsteroidBelt
+{
+public:
+
+    // Scatters count rocks between the two radii, in world units, around the
+    // origin in the XZ plane, and registers their program and mesh with the
+    // queue. Expects a current OpenGL context.
+    AsteroidBelt(RenderQueue & queue, int count, float innerRadius, float outerRadius, unsigned int seed = 1);
+    ~AsteroidBelt();
+
+    // Queues the rocks within the frustum, with the ring turned by angle
+    // radians about +Y. The camera comes from the shared Camera uniform block.
+    void submit(RenderQueue & queue, Frustum const & frustum, glm::vec3 const & lightPos, float angle);
+
+    int size() const { return mCount; }
+
+    // Rocks queued and culled by the last submit.
+    int drawn() const { return mDrawn; }
+    int culled() const { return mCount - mDrawn; }
+
+private:
+
+    // Disable Copying and Assignment
+    AsteroidBelt(AsteroidBelt const &) = delete;
+    AsteroidBelt & operator=(AsteroidBelt const &) = delete;
+
+    // Private Member Variables
+    Mirage::Shader mShader;
+    std::unique_ptr<Mirage::Mesh> mRock;
+    BoundingVolumeHierarchy mClusters;
+    std::vector<BoundingVolumeHierarchy::Range> mRuns;
+    GLuint mInstances;
+    glm::vec3 mLightPos;
+    RenderQueue::Id mProgram;
+    RenderQueue::Id mMaterial;
+    RenderQueue::Id mMesh;
+    int    mCount;
+    int    mDrawn;
+};
+
+#endif //~ Asteroid Belt Header
@@ -0,0 +1,58 @@
+// Preprocessor Directives
+#ifndef BENCHMARK
+#define BENCHMARK
+#pragma once
+
+// Local Headers
+#include "glitter.hpp"
+#include "solar_system.hpp"
+
+// Standard Headers
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Measures every frame in parts: the CPU time spent updating the scene and
+// issuing its GL commands, the GL time the driver reports for executing them
+// (a GL_TIME_ELAPSED query) and the time glFinish() then blocked for. Software
+// rasterizers do most of their work in that last part, so it is kept separate
+// from the query. Each frame is finished before the next one starts so that
+// consecutive frames never overlap.
+class FrameTimer
+{
+public:
+
+    FrameTimer();
+    ~FrameTimer();
+
+    // Bracket the work of a single frame.
+    void begin();
+    void end();
+
+    // Prints the p50/p95/p99 of every recorded series, in milliseconds.
+    void report(FILE * stream) const;
+
+private:
+
+    // Disable Copying and Assignment
+    FrameTimer(FrameTimer const &) = delete;
+    FrameTimer & operator=(FrameTimer const &) = delete;
+
+    // Private Member Variables
+    GLuint mQuery;
+    std::chrono::steady_clock::time_point mStart;
+    std::vector<double> mCpu;
+    std::vector<double> mGL;
+    std::vector<double> mFinish;
+    std::vector<double> mFrame;
+};
+
+// Renders a fixed number of frames with a fixed time step along a
+// deterministic camera path around the Sun, then reports the frame timings.
+// A few warm-up frames are rendered first and left out of the statistics.
+// If the scene's simulation thread runs, frames show its interpolated ticks
+// rather than stepping the simulation themselves. With the profiler enabled
+// the timings of every pass follow.
+void runBenchmark(SolarSystem & scene, Camera & camera, int frames);
+
+#endif //~ Benchmark Header
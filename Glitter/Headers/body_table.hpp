@@ -0,0 +1,91 @@
+// Preprocessor Directives
+#ifndef BODY_TABLE
+#define BODY_TABLE
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <vector>
+
+// Describes one body when it is added to the table. Angles are in radians and
+// the spin rate is per second.
+struct Body
+{
+    Body()
+        : parent(-1)
+        , spinRate(0.0f)
+        , spinAxis(0.0f, 1.0f, 0.0f)
+        , tilt(0.0f)
+        , tiltAxis(0.0f, 0.0f, 1.0f)
+        , scale(1.0f) {}
+
+    int       parent;       // index of the body orbited, or -1 for the origin
+    float     spinRate;
+    glm::vec3 spinAxis;
+    float     tilt;
+    glm::vec3 tiltAxis;
+    float     scale;
+};
+
+// Structure-of-arrays table of every body in the scene. Orbit positions are
+// supplied from outside as offsets from the parent body; one pass over the
+// arrays then builds every model matrix, as
+// translate(offset) * rotate(tilt) * rotate(spin) * scale, four bodies at a
+// time with SSE2 where available. Bodies orbiting another body are moved by
+// their parent's position afterwards, so parents must be added first.
+//
+// The same pass writes each body's normal matrix, the inverse transpose of
+// the model's upper 3x3. Bodies only rotate and scale uniformly, so that is
+// the rotation divided by the scale and needs no inverse. The matrices are
+// stored as three padded columns, the layout the render queue uploads.
+class BodyTable
+{
+public:
+
+    // Appends a body and returns its index.
+    int add(Body const & body);
+
+    // Sets the position of a body relative to its parent, in world units.
+    void setOffset(std::size_t i, glm::vec3 const & offset);
+
+    // Spins every body to the given time, in seconds, and rebuilds the model
+    // matrices from the current offsets.
+    void update(float time);
+
+    // Accessors
+    std::size_t       size() const { return mScale.size(); }
+    glm::mat4 const & model(std::size_t i) const { return mModels[i]; }
+    glm::mat4 const * models() const { return mModels.data(); }
+    glm::mat3x4 const & normal(std::size_t i) const { return mNormals[i]; }
+    glm::vec3         position(std::size_t i) const { return glm::vec3(mModels[i][3]); }
+
+private:
+
+    // Position Relative to the Parent
+    std::vector<int>   mParent;
+    std::vector<float> mOffsetX;
+    std::vector<float> mOffsetY;
+    std::vector<float> mOffsetZ;
+
+    // Spin Around a Normalized Axis
+    std::vector<float> mSpinRate;
+    std::vector<float> mSpinAxisX;
+    std::vector<float> mSpinAxisY;
+    std::vector<float> mSpinAxisZ;
+
+    // Tilt Rotation, Stored as a Column-Major 3x3 Matrix
+    std::vector<float> mTilt[9];
+    std::vector<float> mScale;
+
+    // Indices of the Bodies With a Parent, in Insertion Order
+    std::vector<int>   mSatellites;
+
+    // Output
+    std::vector<glm::mat4> mModels;
+    std::vector<glm::mat3x4> mNormals;
+};
+
+#endif //~ Body Table Header
@@ -0,0 +1,100 @@
+// Preprocessor Directives
+#ifndef CULLING
+#define CULLING
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Sample Headers
+#include <mesh.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The six planes of a view frustum, pointing inwards and normalized, taken
+// from a projection-view matrix (Gribb and Hartmann). A sphere is visible
+// unless it lies wholly behind one of them; the test is conservative near the
+// corners, which only costs a draw that could have been skipped.
+class Frustum
+{
+public:
+
+    explicit Frustum(glm::mat4 const & projectionView);
+
+    // The same frustum seen from an object's local space, given the object's
+    // model matrix, so that local bounds can be tested without moving them.
+    Frustum local(glm::mat4 const & model) const;
+
+    bool visible(Mirage::Sphere const & sphere) const;
+
+    // Tests count spheres stored as structure-of-arrays and writes 1 for each
+    // visible one and 0 otherwise; one plane at a time over the whole batch.
+    void visible(float const * x, float const * y, float const * z, float const * radius,
+                 std::size_t count, std::uint8_t * result) const;
+
+    // Classifies a box as outside (-1), crossing (0) or inside (1).
+    int classify(glm::vec3 const & lower, glm::vec3 const & upper) const;
+
+private:
+
+    Frustum() {}
+
+    glm::vec4 mPlanes[6];
+};
+
+// Bounding volume hierarchy over a set of spheres, stored as a flat array of
+// boxes. Building sorts the items so that every node covers a contiguous run
+// of them; a query returns those runs, which lets callers lay out per-item
+// data in the same order and draw each run with one call. Items that move can
+// be refitted in place, keeping the tree, as long as they move coherently.
+class BoundingVolumeHierarchy
+{
+public:
+
+    // A run of items, as positions in order().
+    struct Range
+    {
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    // Splits the items at the median of the longest axis of their centers
+    // until each leaf holds at most leafSize of them.
+    void build(std::vector<Mirage::Sphere> const & items, std::size_t leafSize = 4);
+
+    // Recomputes every box for items that have moved since the build.
+    void refit(std::vector<Mirage::Sphere> const & items);
+
+    // Appends the runs of items whose node is not outside the frustum; runs
+    // that follow each other are merged.
+    void query(Frustum const & frustum, std::vector<Range> & ranges) const;
+
+    // Item index at each position, in leaf order.
+    std::vector<std::uint32_t> const & order() const { return mOrder; }
+    std::size_t size() const { return mOrder.size(); }
+
+private:
+
+    struct Node
+    {
+        glm::vec3     lower;
+        std::uint32_t first;  // first item, in order()
+        glm::vec3     upper;
+        std::uint32_t count;  // items below this node
+        std::uint32_t right;  // second child, or 0 for a leaf; the first follows the node
+    };
+
+    // Private Member Functions
+    std::uint32_t split(std::vector<Mirage::Sphere> const & items, std::uint32_t first,
+                        std::uint32_t count, std::size_t leafSize);
+    void bound(Node & node, std::vector<Mirage::Sphere> const & items) const;
+
+    // Private Member Variables
+    std::vector<Node> mNodes;
+    std::vector<std::uint32_t> mOrder;
+};
+
+#endif //~ Culling Header
@@ -0,0 +1,93 @@
+// Preprocessor Directives
+#ifndef EPHEMERIS
+#define EPHEMERIS
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Sample Headers
+#include <mapped_file.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Precomputed positions of a set of bodies over a span of dates, stored as
+// piecewise Chebyshev polynomials in a memory-mapped file, the way JPL's DE
+// files are. Time is cut into records of equal length; within a record each
+// body has its own number of equal sub-intervals, more for faster bodies, and
+// per sub-interval one polynomial per axis. Finding a body at any date is an
+// index computation and a short Clenshaw sum, whether the date is the next
+// frame or centuries away, and only the records touched are ever paged in.
+// Positions are whatever the source gave when the file was generated; for
+// the scene, kilometers relative to the parent along the ecliptic axes.
+class Ephemeris
+{
+public:
+
+    // Bump whenever the file layout changes.
+    static const std::uint32_t Version = 1;
+
+    // Writes the position of every body at a Julian date.
+    typedef std::function<void(double julianDate, double * x, double * y, double * z)> Source;
+
+    Ephemeris();
+
+    // Maps a file and validates it against the key of the data it was
+    // generated from; false if it is missing, malformed or stale.
+    bool open(std::string const & path, std::uint64_t key);
+    bool valid() const { return mRecords != nullptr; }
+
+    // Dates covered, as Julian dates, end excluded.
+    double start() const { return mStart; }
+    double end() const { return mStart + mSpan * mRecordCount; }
+    bool   covers(double julianDate) const { return valid() && julianDate >= start() && julianDate < end(); }
+    std::size_t size() const { return mBodyCount; }
+
+    // Writes the position of every body at a covered date; the arrays are
+    // laid out like KeplerPropagator::propagate's.
+    void positions(double julianDate, double * x, double * y, double * z) const;
+    glm::dvec3 position(std::size_t body, double julianDate) const;
+
+    // Fits the source over [start, end) in records of span days, with the
+    // given number of coefficients per axis, and writes the file. Each body
+    // gets the fewest sub-intervals, a power of two up to 64, that keep it
+    // within tolerance of the source at points between the fitting nodes;
+    // the largest error met is returned through maxError.
+    static bool generate(std::string const & path, std::uint64_t key, std::size_t bodies, Source const & source,
+                         double start, double end, double span = 32.0, int coefficients = 12,
+                         double tolerance = 1.0, double * maxError = nullptr);
+
+private:
+
+    // Disable Copying and Assignment
+    Ephemeris(Ephemeris const &) = delete;
+    Ephemeris & operator=(Ephemeris const &) = delete;
+
+    // Where a body's polynomials sit in each record
+    struct Layout
+    {
+        std::uint32_t offset;       // doubles into the record
+        std::uint32_t coefficients; // per axis
+        std::uint32_t subintervals;
+        std::uint32_t reserved;
+    };
+
+    // Private Member Functions
+    glm::dvec3 evaluate(Layout const & layout, double const * record, double fraction) const;
+
+    // Private Member Variables
+    Mirage::MappedFile mFile;
+    Layout const * mLayouts;
+    double const * mRecords;
+    std::uint32_t mBodyCount;
+    std::uint32_t mRecordCount;
+    std::uint32_t mRecordSize;
+    double mStart;
+    double mSpan;
+};
+
+#endif //~ Ephemeris Header
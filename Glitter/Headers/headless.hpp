@@ -0,0 +1,38 @@
+// Preprocessor Directives
+#ifndef HEADLESS
+#define HEADLESS
+#pragma once
+
+// Local Headers
+#include "glitter.hpp"
+
+// Creates an OpenGL core context without a window system, through EGL on the
+// Mesa surfaceless platform (llvmpipe when there is no GPU), along with a
+// framebuffer object that stands in for the missing default framebuffer.
+// Only available on Linux builds where CMake found libEGL.
+class HeadlessContext
+{
+public:
+
+    HeadlessContext(int width, int height);
+    ~HeadlessContext();
+
+    // Returns true when the context is current and the framebuffer complete.
+    bool valid() const { return mValid; }
+
+private:
+
+    // Disable Copying and Assignment
+    HeadlessContext(HeadlessContext const &) = delete;
+    HeadlessContext & operator=(HeadlessContext const &) = delete;
+
+    // Private Member Variables
+    void * mDisplay;
+    void * mContext;
+    GLuint mFramebuffer;
+    GLuint mColorBuffer;
+    GLuint mDepthBuffer;
+    bool   mValid;
+};
+
+#endif //~ Headless Header
@@ -0,0 +1,63 @@
+// Preprocessor Directives
+#ifndef ICOSPHERE
+#define ICOSPHERE
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+// Sample Headers
+#include <mesh.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A sphere tessellated at a few levels of detail, built once and shared by
+// every spherical body, each of which draws it with its own textures. Level n
+// is an icosahedron whose faces are split in four n times and pushed out onto
+// the sphere, so it has 20 * 4^n triangles of nearly equal size. Texture
+// coordinates are equirectangular, with the north pole on +Y at v = 0, as in
+// the usual planet maps. Every level lives in one mesh, one after the other,
+// so spheres of any detail can be drawn from a single vertex array.
+class Icosphere
+{
+public:
+
+    // Levels built, from 20 triangles up to 20480.
+    static const int Levels = 6;
+
+    // Expects a current OpenGL context; uploads every level.
+    explicit Icosphere(float radius);
+
+    // Builds the vertices and indices of one level without touching GL.
+    static void build(int subdivisions, float radius,
+                      std::vector<Mirage::Vertex> & vertices, std::vector<unsigned int> & indices);
+
+    // Level for a sphere that covers the given radius in pixels, such that
+    // its edges stay a few pixels long. A sphere only leaves its current level
+    // once its size is a margin past where the choice changes, so one hovering
+    // near the threshold does not flip between two levels every frame.
+    static int select(float pixelRadius, int current);
+
+    // Public Member Functions
+    Mirage::Mesh & mesh() { return *mMesh; }
+    GLuint firstIndex(int index) const { return mFirstIndex[index]; }
+    GLsizei indexCount(int index) const { return static_cast<GLsizei>(triangles(index) * 3); }
+    std::size_t triangles(int index) const { return std::size_t(20) << (2 * index); }
+    Mirage::Sphere const & bounds() const { return mMesh->bounds(); }
+    std::size_t gpuBytes() const { return mMesh->gpuBytes(); }
+
+private:
+
+    // Disable Copying and Assignment
+    Icosphere(Icosphere const &) = delete;
+    Icosphere & operator=(Icosphere const &) = delete;
+
+    // Private Member Variables
+    std::unique_ptr<Mirage::Mesh> mMesh;
+    GLuint mFirstIndex[Levels];
+};
+
+#endif //~ Icosphere Header
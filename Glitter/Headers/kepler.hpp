@@ -0,0 +1,84 @@
+// Preprocessor Directives
+#ifndef KEPLER
+#define KEPLER
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <vector>
+
+// Julian date of the J2000 epoch, which every set of elements refers to.
+const double J2000 = 2451545.0;
+
+// Kilometers per astronomical unit.
+const double AU = 149597870.7;
+
+// Classical orbital elements at J2000 and their rates per Julian century, laid
+// out like JPL's "Keplerian Elements for Approximate Positions of the Major
+// Planets". Distances are in kilometers and angles in degrees; longitudes are
+// measured in the ecliptic from the equinox.
+struct OrbitalElements
+{
+    double semiMajorAxis;
+    double eccentricity;
+    double inclination;
+    double meanLongitude;
+    double perihelionLongitude;
+    double ascendingNode;
+
+    double semiMajorAxisRate;
+    double eccentricityRate;
+    double inclinationRate;
+    double meanLongitudeRate;
+    double perihelionLongitudeRate;
+    double ascendingNodeRate;
+};
+
+// Evaluates Keplerian orbits in closed form at any epoch, so the cost of a
+// query is the same whether it is the next frame or a century away. Elements
+// are stored as structure-of-arrays and every stage, including the Newton
+// solve of Kepler's equation, runs as a batch over all bodies, in double
+// precision throughout.
+class KeplerPropagator
+{
+public:
+
+    // Appends an orbit and returns its index.
+    int add(OrbitalElements const & elements);
+
+    // Writes the position of every body relative to the body it orbits, in
+    // kilometers along the J2000 ecliptic axes, at the given Julian date.
+    void propagate(double julianDate, double * x, double * y, double * z);
+
+    // Samples an orbit at points evenly spaced in eccentric anomaly, starting
+    // at the periapsis, using the elements as they are at the given date.
+    void sample(std::size_t body, double julianDate, int count, std::vector<glm::dvec3> & points) const;
+
+    std::size_t size() const { return mSemiMajorAxis.size(); }
+
+private:
+
+    // Elements at J2000, in kilometers and radians
+    std::vector<double> mSemiMajorAxis;
+    std::vector<double> mEccentricity;
+    std::vector<double> mInclination;
+    std::vector<double> mMeanLongitude;
+    std::vector<double> mPerihelionLongitude;
+    std::vector<double> mAscendingNode;
+
+    // Rates per Julian century
+    std::vector<double> mSemiMajorAxisRate;
+    std::vector<double> mEccentricityRate;
+    std::vector<double> mInclinationRate;
+    std::vector<double> mMeanLongitudeRate;
+    std::vector<double> mPerihelionLongitudeRate;
+    std::vector<double> mAscendingNodeRate;
+
+    // Scratch Space Reused Between Calls
+    std::vector<double> mA, mE, mI, mM, mArgument, mNode, mAnomaly;
+};
+
+#endif //~ Kepler Header
@@ -0,0 +1,163 @@
+// Preprocessor Directives
+#ifndef NBODY
+#define NBODY
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Standard Headers
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Gravitational constant in astronomical units, days and solar masses: the
+// square of the Gaussian gravitational constant.
+const double GaussianGravity = 0.01720209895 * 0.01720209895;
+
+// Newtonian gravity between point masses, in astronomical units, days and
+// solar masses, stepped with a kick-drift-kick leapfrog. Forces come from a
+// Barnes-Hut octree rebuilt every step: particles are sorted by the Morton
+// key of their position, so every cell of the tree covers a contiguous run of
+// them, and the state arrays are kept in that order. Sorting, building and
+// the force walk are split across a pool of threads. Each leaf walks the tree
+// once for all of its particles, collecting far cells as point masses and
+// near particles one by one, and then sums that list for every particle.
+class NBodyEngine
+{
+public:
+
+    // Time spent in the last step, and the interactions it summed.
+    struct Stats
+    {
+        double build;        // sort and tree construction, in milliseconds
+        double forces;       // tree walk and summation, in milliseconds
+        std::size_t nodes;
+        std::size_t interactions;
+    };
+
+    // A cell is taken as a point mass when its size over its distance is
+    // below theta. Softening, in astronomical units, keeps close pairs
+    // finite; zero threads means one per hardware thread.
+    explicit NBodyEngine(double theta = 0.5, double softening = 1e-9, unsigned int threads = 0);
+    ~NBodyEngine();
+
+    // Appends a particle and returns its id, which stays the same however the
+    // particles are reordered.
+    std::size_t add(double mass, glm::dvec3 const & position, glm::dvec3 const & velocity);
+    void reserve(std::size_t count);
+    void clear();
+
+    // Advances every particle by dt days.
+    void step(double dt);
+
+    // State of a particle by id.
+    glm::dvec3 position(std::size_t id) const;
+    glm::dvec3 velocity(std::size_t id) const;
+    double     mass(std::size_t id) const { return mMass[mSlot[id]]; }
+
+    std::size_t size() const { return mId.size(); }
+    unsigned int threads() const { return static_cast<unsigned int>(mWorkers.size()) + 1; }
+    Stats const & stats() const { return mStats; }
+
+private:
+
+    // Disable Copying and Assignment
+    NBodyEngine(NBodyEngine const &) = delete;
+    NBodyEngine & operator=(NBodyEngine const &) = delete;
+
+    // A cubic cell of the tree, as its mass and center of mass, and the run
+    // of sorted particles it covers. It is far enough from a point to stand
+    // for its particles once their distance exceeds reach.
+    struct Node
+    {
+        double x, y, z;
+        double mass;
+        double reach;
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t child;     // first child, or 0 for a leaf
+        std::uint32_t children;  // the others follow the first
+    };
+
+    // Cell whose subtree is left to a worker, or whose moments wait for its
+    // children, by the serial top of the build
+    struct Subtree
+    {
+        std::uint32_t node;
+        std::uint32_t begin;
+        std::uint32_t end;
+        int level;
+        glm::dvec3 center;
+    };
+
+    // Morton key of a particle and its slot before sorting
+    struct Keyed
+    {
+        std::uint64_t key;
+        std::uint32_t index;
+    };
+
+    // Private Member Functions
+    void sort();
+    void build();
+    void fill(std::vector<Node> & nodes, std::uint32_t index, std::uint32_t begin, std::uint32_t end,
+              int level, glm::dvec3 center, std::size_t grain, std::vector<Subtree> * deferred,
+              std::vector<Subtree> * pending);
+    void moments(Node & node, std::vector<Node> const & nodes, int level, glm::dvec3 const & center) const;
+    void accelerate();
+    void kick(double dt);
+    void drift(double dt);
+
+    // Runs body over [0, count) in chunks of grain on every thread, the
+    // calling one included, and returns once all chunks are done.
+    void parallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> const & body);
+    void work();
+
+    // Settings
+    double mTheta;
+    double mSoftening;
+
+    // Particles in Morton order, the id of each, and the slot of each id
+    std::vector<double> mX, mY, mZ;
+    std::vector<double> mVX, mVY, mVZ;
+    std::vector<double> mAX, mAY, mAZ;
+    std::vector<double> mMass;
+    std::vector<std::uint32_t> mId;
+    std::vector<std::uint32_t> mSlot;
+    bool mAccelerated;
+
+    // Tree of the current step, its bounding cube and the leaves in order
+    std::vector<Node> mNodes;
+    std::vector<std::uint32_t> mLeaves;
+    glm::dvec3 mCorner;
+    double mSize;
+
+    // Scratch Space Reused Between Steps
+    std::vector<Keyed> mKeys;
+    std::vector<Keyed> mMerged;
+    std::vector<double> mScratch;
+    std::vector<std::uint32_t> mScratchId;
+
+    // Worker Pool; a Job Is a Generation Number Workers Wait to Change
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mJobReady;
+    std::condition_variable mJobDone;
+    std::function<void(std::size_t, std::size_t)> const * mJob;
+    std::size_t mJobCount;
+    std::size_t mJobGrain;
+    std::atomic<std::size_t> mJobNext;
+    unsigned long mGeneration;
+    unsigned int mBusy;
+    bool mStopping;
+
+    Stats mStats;
+};
+
+#endif //~ NBody Header
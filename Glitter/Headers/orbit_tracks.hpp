@@ -0,0 +1,93 @@
+// Preprocessor Directives
+#ifndef ORBIT_TRACKS
+#define ORBIT_TRACKS
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Sample Headers
+#include <shader.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Closed orbit lines, each tessellated by its size on screen: a power of two
+// of segments between MinSegments and MaxSegments, chosen so that the chords
+// stray less than about half a pixel from the curve. Every track owns a slot
+// in one buffer, as large as the finest tessellation it has had since the
+// buffer was last packed. A track whose tessellation changes is resampled and
+// rewritten in its slot, or in a new one at the end of the buffer when it
+// outgrows it; the others stay untouched, and all of them are drawn with a
+// single glMultiDrawArrays. When the end is full, the buffer is packed again
+// at twice the size of the tracks it holds.
+class OrbitTracks
+{
+public:
+
+    // Writes count points evenly spaced around a track, in world units.
+    typedef std::function<void(std::size_t track, int count, std::vector<glm::vec3> & points)> Sampler;
+
+    static const int MinSegments = 16;
+    static const int MaxSegments = 4096;
+
+    // Expects a current OpenGL context; samples every track at the coarsest
+    // tessellation until the first update.
+    OrbitTracks(std::size_t count, Sampler sampler);
+    ~OrbitTracks();
+
+    // Picks the tessellation of every track as seen from the eye, where a
+    // unit of length one unit away covers pixelsPerUnit pixels, and
+    // re-uploads the tracks whose tessellation changed.
+    void update(glm::vec3 const & eye, float pixelsPerUnit);
+
+    // Draws every track as a line loop in one call. The camera comes from
+    // the shared Camera uniform block.
+    void draw();
+
+    std::size_t size() const { return mTracks.size(); }
+
+    // Segments drawn, and tracks re-uploaded by the last update.
+    int segments() const;
+    int uploads() const { return mUploads; }
+
+private:
+
+    // Disable Copying and Assignment
+    OrbitTracks(OrbitTracks const &) = delete;
+    OrbitTracks & operator=(OrbitTracks const &) = delete;
+
+    // Circle that stands in for a track when measuring it: the mean distance
+    // of its points from their centroid, in the plane of the orbit
+    struct Track
+    {
+        glm::vec3 center;
+        glm::vec3 normal;
+        float     radius;
+        int       level; // segments are MinSegments << level
+        int       slot;  // vertices reserved from its first
+    };
+
+    // Private Member Functions
+    void upload(std::size_t index, int level);
+    void reserve(std::size_t index, int count);
+    void repack(std::size_t index, int count);
+
+    // Private Member Variables
+    Mirage::Shader mShader;
+    Sampler mSampler;
+    std::vector<Track> mTracks;
+    std::vector<GLint> mFirsts;
+    std::vector<GLsizei> mCounts;
+    std::vector<glm::vec3> mPoints;
+    GLuint mVertexArray;
+    GLuint mBuffer;
+    std::size_t mUsed;     // vertices up to the end of the last slot
+    std::size_t mCapacity; // vertices the buffer holds
+    int mUploads;
+};
+
+#endif //~ Orbit Tracks Header
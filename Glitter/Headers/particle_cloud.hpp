@@ -0,0 +1,52 @@
+// Preprocessor Directives
+#ifndef PARTICLE_CLOUD
+#define PARTICLE_CLOUD
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Sample Headers
+#include <shader.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <vector>
+
+// Particles too many and too small to draw as meshes, drawn as single points
+// in one call. Their positions are rewritten whole whenever a new set
+// arrives; the buffer is orphaned first, so the driver never waits for the
+// previous frame to finish reading it.
+class ParticleCloud
+{
+public:
+
+    // Expects a current OpenGL context.
+    explicit ParticleCloud(glm::vec4 const & color);
+    ~ParticleCloud();
+
+    // Replaces every position, in world units.
+    void upload(std::vector<glm::vec3> const & points);
+
+    // Draws the points. The camera comes from the shared Camera uniform block.
+    void draw();
+
+    std::size_t size() const { return mCount; }
+
+private:
+
+    // Disable Copying and Assignment
+    ParticleCloud(ParticleCloud const &) = delete;
+    ParticleCloud & operator=(ParticleCloud const &) = delete;
+
+    // Private Member Variables
+    Mirage::Shader mShader;
+    glm::vec4 mColor;
+    GLuint mVertexArray;
+    GLuint mBuffer;
+    std::size_t mCapacity;
+    std::size_t mCount;
+};
+
+#endif //~ Particle Cloud Header
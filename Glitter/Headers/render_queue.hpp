@@ -0,0 +1,196 @@
+// Preprocessor Directives
+#ifndef RENDER_QUEUE
+#define RENDER_QUEUE
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Local Headers
+#include "stream_buffer.hpp"
+
+// Sample Headers
+#include <gl_object.hpp>
+#include <mesh.hpp>
+#include <profiler.hpp>
+#include <shader.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Collects the mesh draws of a frame and issues them sorted by a packed
+// 64-bit key: program in the top 8 bits, then texture set and vertex array in
+// 16 bits each, then depth in the low 24 bits, nearest first. Draws that share
+// a program, material or vertex array end up next to each other, and each of
+// them is bound once per run rather than once per draw.
+//
+// Programs, materials and meshes are registered at load time and referred to
+// by small ids afterwards, so that submitting a draw is a constant amount of
+// work however many there are.
+//
+// Plain draws make no GL call of their own. Their model and normal matrices
+// are written, in draw order, into a stream buffer that the vertex shader
+// reads as the texture buffer "objects", and each draw picks its object by
+// its base instance (see Mesh::bindObjects). A run of draws that share a
+// program, material and vertex array, whatever part of the vertices each
+// draws, then goes out in one glMultiDrawElementsIndirect. Shaders sample
+// their textures from the bound units, so a change of material still ends a
+// run; bodies with maps of their own are a call each. Contexts older than
+// GL 4.3 issue the run draw by draw, and older than 4.2 also set the object
+// index as a constant attribute before each draw. Instanced draws keep the
+// model matrix as the "model" uniform.
+//
+// Normal matrices come with the draw when the caller already has them, as
+// the body table does; otherwise the queue derives one from the model matrix
+// with three cross products, so no shader ever inverts a matrix.
+class RenderQueue
+{
+public:
+
+    typedef std::uint16_t Id;
+
+    // Texture unit of the objects buffer, past every material unit.
+    static const GLint ObjectUnit = 16;
+
+    // Data of a plain draw, seven RGBA32F texels of the objects buffer: the
+    // model matrix, then the normal matrix as three columns.
+    struct Object
+    {
+        glm::mat4   model;
+        glm::mat3x4 normal;
+    };
+
+    // Bindings made by the last execute(), for measuring.
+    struct Stats
+    {
+        int draws;
+        int calls; // draw calls issued, a multi-draw counting once
+        int programs;
+        int materials;
+        int vertexArrays;
+    };
+
+    // Expects a current OpenGL context.
+    RenderQueue();
+
+    // Registers a program; setup is called each frame right after the program
+    // is made current, to set uniforms that do not change between its draws.
+    // The draws of a program are profiled as one pass under its name.
+    Id program(Mirage::Shader & shader, char const * name, std::function<void(Mirage::Shader &)> setup = nullptr);
+
+    // Registers a set of textures, which must stay in place while the queue
+    // is in use. Sets with the same textures on the same units share an id.
+    Id material(std::vector<Mirage::Texture> const & textures);
+
+    // Registers a mesh, which must stay in place while the queue is in use;
+    // each mesh is registered once. The second form registers a range of its
+    // indices, so that draws of different parts of one mesh can be batched.
+    Id mesh(Mirage::Mesh & mesh);
+    Id mesh(Mirage::Mesh & mesh, GLuint firstIndex, GLsizei indexCount);
+
+    // Starts a frame seen from far away as the far plane; depths beyond it
+    // sort last.
+    void begin(float farPlane);
+
+    // Queues a draw of a mesh with a material and model matrix, at the given
+    // distance from the eye. The second form takes the normal matrix as well,
+    // in padded columns. The third draws count instances from an instance
+    // buffer, starting at instance first (see Mesh::drawInstanced).
+    void submit(Id program, Id material, Id mesh, glm::mat4 const & model, float depth);
+    void submit(Id program, Id material, Id mesh, glm::mat4 const & model, glm::mat3x4 const & normal,
+                float depth);
+    void submit(Id program, Id material, Id mesh, glm::mat4 const & model, float depth,
+                GLuint instances, GLsizei count, GLsizei first);
+
+    // Sorts the frame's draws and issues them, skipping every binding that
+    // is already in place.
+    void execute();
+
+    Stats const & stats() const { return mStats; }
+
+private:
+
+    // Disable Copying and Assignment
+    RenderQueue(RenderQueue const &) = delete;
+    RenderQueue & operator=(RenderQueue const &) = delete;
+
+    struct Program
+    {
+        Mirage::Shader * shader;
+        char const * name;
+        std::function<void(Mirage::Shader &)> setup;
+        GLint model;
+        GLint objects;
+        GLint positionScale;
+        GLint positionOffset;
+        GLint octahedralNormals;
+    };
+
+    struct Range
+    {
+        Mirage::Mesh * mesh;
+        GLuint         firstIndex;
+        GLsizei        indexCount;
+    };
+
+    // Layout glMultiDrawElementsIndirect reads
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct Command
+    {
+        glm::mat4   model;
+        glm::mat3x4 normal; // unused by instanced draws
+        Id          program;
+        Id          material;
+        Id          mesh;
+        GLuint      instances; // 0 for a plain draw
+        GLsizei     count;
+        GLsizei     first;
+    };
+
+    // Private Member Functions
+    std::uint64_t key(Id program, Id material, Id mesh, float depth) const;
+    void writeObjects();
+    void drawRun(std::size_t begin, std::size_t end, std::size_t plain);
+
+    // Registered Objects
+    std::vector<Program> mPrograms;
+    std::vector<std::vector<Mirage::Texture> const *> mMaterials;
+    std::map<std::vector<std::tuple<void const *, GLuint, GLint>>, Id> mMaterialIds;
+    std::vector<Range> mMeshes;
+
+    // Draws of the Current Frame, and Their Keys Paired With Their Index
+    std::vector<Command> mCommands;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> mOrder;
+    std::size_t mPlain;
+    float mFar;
+    Stats mStats;
+
+    // Objects and Indirect Commands of the Plain Draws, One Each, and the
+    // Consecutive Indices That Pick an Object by Base Instance
+    StreamBuffer mObjects;
+    StreamBuffer mDraws;
+    Mirage::TextureObject mObjectTexture;
+    Mirage::Buffer mObjectIndices;
+    GLuint mObjectBuffer; // what the texture and indices were made for
+    GLuint mFirstObject;  // object of the first plain draw this frame
+    bool mIndirect;
+    bool mBaseInstance;
+};
+
+#endif //~ Render Queue Header
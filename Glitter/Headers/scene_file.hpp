@@ -0,0 +1,136 @@
+// Preprocessor Directives
+#ifndef SCENE_FILE
+#define SCENE_FILE
+#pragma once
+
+// Local Headers
+#include "kepler.hpp"
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything the scene is made of, read from a text file so that it can be
+// changed, or generated at any size, without building again. The file is a
+// list of blocks, each opened by a line naming its kind, and followed by one
+// property per line; '#' starts a comment:
+//
+//     body Earth
+//         surface Models/Earth/4_no_ice_clouds_mts_8k.jpg
+//         orbit   1.00000261au 0.01671123 -0.00001531 100.46457166 102.93768193 0
+//         rates   0.00000562au -0.00004392 -0.01294668 35999.37244981 0.32327364 0
+//         mass    3.0035e-6
+//         offset  150
+//         spin    447.04 0 1 0
+//         tilt    -20 0 0 1
+//         scale   0.1
+//
+// A body has a model or a surface map wrapped around a sphere, and may name
+// an earlier body as its parent. orbit and rates are its orbital elements
+// and their rates per century relative to the parent (see OrbitalElements),
+// with distances in kilometers, or in astronomical units when followed by
+// "au". The first body is the star that lights the others. A belt block
+// describes the rocks drawn between two radii around it, and population
+// blocks the particles of the gravity mode; see below for their properties.
+class SceneFile
+{
+public:
+
+    // Default scene, relative to the working directory.
+    static const char * const DefaultPath;
+
+    // One body. Angles are in degrees and the spin is per second; the offset
+    // is added to the distance from the parent after scaling into the scene.
+    struct Body
+    {
+        Body()
+            : parent(-1)
+            , elements()
+            , mass(0.0)
+            , offset(0.0f)
+            , spin(0.0f)
+            , spinAxis(0.0f, 1.0f, 0.0f)
+            , tilt(0.0f)
+            , tiltAxis(0.0f, 0.0f, 1.0f)
+            , scale(1.0f) {}
+
+        std::string     name;
+        std::string     model;   // path of a model, or empty
+        std::string     surface; // path of a map wrapped around a sphere, or empty
+        int             parent;  // index of an earlier body, or -1 for the star
+        OrbitalElements elements;
+        double          mass;    // solar masses
+        float           offset;
+        float           spin;
+        glm::vec3       spinAxis;
+        float           tilt;
+        glm::vec3       tiltAxis;
+        float           scale;
+    };
+
+    // Rocks drawn around the star between two radii, in kilometers, turning
+    // as a whole once a period, in days; properties radii, period, offset
+    // and rocks.
+    struct Belt
+    {
+        Belt() : inner(0.0), outer(0.0), period(0.0), offset(0.0f), rocks(0) {}
+
+        double inner;
+        double outer;
+        double period;
+        float  offset;
+        int    rocks;
+    };
+
+    // Particles of the gravity mode on circular orbits around a body, between
+    // two radii in kilometers, with the spread of their inclinations and the
+    // tilt of their plane from the ecliptic about the equinox, in degrees,
+    // and their total mass in solar masses; properties center, radii,
+    // inclination, mass, offset, tilt and particles.
+    struct Population
+    {
+        Population()
+            : center(0)
+            , inner(0.0)
+            , outer(0.0)
+            , inclination(0.0)
+            , mass(0.0)
+            , offset(0.0f)
+            , tilt(0.0)
+            , particles(0) {}
+
+        std::string name;
+        int    center;
+        double inner;
+        double outer;
+        double inclination;
+        double mass;
+        float  offset;
+        double tilt;
+        int    particles;
+    };
+
+    // Reads a scene, replacing this one; on failure reports the line at
+    // fault on stderr and returns false, leaving this scene empty.
+    bool load(std::string const & path);
+
+    // Writes the scene in the form load() reads.
+    bool save(std::string const & path) const;
+
+    // Index of the population of that name, or -1.
+    int findPopulation(std::string const & name) const;
+
+    // Key of every body's orbital elements, for files derived from them.
+    std::uint64_t elementsKey() const;
+
+    std::vector<Body> bodies;
+    Belt belt;
+    std::vector<Population> populations;
+};
+
+#endif //~ Scene File Header
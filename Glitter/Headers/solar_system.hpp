@@ -0,0 +1,271 @@
+// Preprocessor Directives
+#ifndef SOLAR_SYSTEM
+#define SOLAR_SYSTEM
+#pragma once
+
+// Local Headers
+#include "asteroid_belt.hpp"
+#include "body_table.hpp"
+#include "culling.hpp"
+#include "ephemeris.hpp"
+#include "glitter.hpp"
+#include "icosphere.hpp"
+#include "kepler.hpp"
+#include "nbody.hpp"
+#include "orbit_tracks.hpp"
+#include "particle_cloud.hpp"
+#include "render_queue.hpp"
+#include "scene_file.hpp"
+#include "triple_buffer.hpp"
+
+// Sample Headers
+#include <Camera.h>
+#include <Model.h>
+#include <profiler.hpp>
+#include <shader.hpp>
+#include <virtual_texture.hpp>
+
+// Standard Headers
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Owns every GPU resource of the scene (shaders, planet models, skybox and
+// orbit tracks) and renders one frame of it. Kept free of any windowing code so
+// that the same frame can be drawn into a GLFW window or an offscreen target.
+class SolarSystem
+{
+public:
+
+    // Expects a current OpenGL context; loads every shader, and the models
+    // and maps of the scene's bodies, and scatters the rocks of its belt.
+    explicit SolarSystem(SceneFile const & scene);
+    ~SolarSystem();
+
+    // Moves every body to its place at the simulated date and spins it to the
+    // given wall-clock time, in seconds. The date advances by the time elapsed
+    // since the previous call, multiplied by the time warp.
+    void update(float time);
+
+    // Runs the orbits on a thread of their own instead, at a fixed number of
+    // ticks per second, until stopSimulation() or destruction. Each tick is
+    // published through a triple buffer; update() must not be called while
+    // the thread runs.
+    void startSimulation(double ticksPerSecond);
+    void stopSimulation();
+    bool simulating() const { return mSimulation.joinable(); }
+
+    // Moves the bodies by their mutual gravity from now on, seeded from their
+    // orbits at the current date, together with the particles of the scene's
+    // populations, which are drawn as points. Must be called before
+    // startSimulation().
+    void useGravity();
+    NBodyEngine const * gravity() const { return mGravity.get(); }
+
+    // Places every body between the two newest ticks of the simulation
+    // thread, one tick behind the clock, so that motion stays smooth whether
+    // frames come faster or slower than ticks.
+    void interpolate();
+
+    // Jumps to a Julian date, or changes how many simulated days pass per
+    // second; either may be called while the simulation thread runs.
+    void seek(double julianDate) { mEpoch = julianDate; mSeek = julianDate; }
+    void setTimeWarp(double daysPerSecond) { mTimeWarp = daysPerSecond; }
+    double epoch() const { return mEpoch; }
+
+    // Reads orbits from a precomputed ephemeris at the dates it covers, and
+    // from the orbital elements elsewhere; false if the file is missing or
+    // was generated from other elements.
+    bool useEphemeris(std::string const & path);
+
+    // Fits the orbits of every body of a scene from one Julian date to
+    // another and writes them as an ephemeris file, returning the largest
+    // error of the fit in kilometers. Needs no OpenGL context.
+    static bool writeEphemeris(SceneFile const & scene, std::string const & path,
+                               double from, double to, double * maxError = nullptr);
+
+    // Bytes held by the body models and spheres on the CPU and on the GPU.
+    std::size_t cpuBytes() const;
+    std::size_t gpuBytes() const;
+
+    // Draws the planets, the Sun, the skybox and the orbit tracks as seen from
+    // the camera. Bodies and belt rocks outside the view frustum are skipped,
+    // and spherical bodies are drawn in as much detail as their size on
+    // screen calls for.
+    void draw(Camera & camera);
+
+    // What frustum culling drew and skipped in the last frame, the triangles
+    // the spheres were drawn with, and the segments of the orbit tracks and
+    // how many tracks were re-uploaded.
+    struct CullCounters
+    {
+        int bodiesDrawn;
+        int bodiesCulled;
+        int rocksDrawn;
+        int rocksCulled;
+        int sphereTriangles;
+        int trackSegments;
+        int trackUploads;
+    };
+    CullCounters const & counters() const { return mCounters; }
+
+    // Draws and bindings the render queue made in the last frame.
+    RenderQueue::Stats const & queueStats() const { return mQueue.stats(); }
+
+    // The maps drawn from tiles, null if no map is large enough to be tiled
+    // (see Mirage::TileFile::setMinResolution).
+    Mirage::VirtualTextures const * virtualTextures() const { return mVirtual.get(); }
+
+private:
+
+    // Disable Copying and Assignment
+    SolarSystem(SolarSystem const &) = delete;
+    SolarSystem & operator=(SolarSystem const &) = delete;
+
+    // Positions of every body relative to its parent at one instant, and the
+    // two latest of them as published by the simulation thread
+    struct Tick
+    {
+        double time;
+        double epoch;
+        std::vector<glm::vec3> offsets;
+    };
+    struct Ticks
+    {
+        Tick previous;
+        Tick current;
+        std::vector<glm::vec3> particles;
+    };
+
+    // Private Member Functions
+    void propagate(double epoch, std::vector<glm::vec3> & offsets, std::vector<glm::vec3> & particles);
+    void gravitate(double epoch, std::vector<glm::vec3> & offsets, std::vector<glm::vec3> & particles);
+    void seedGravity(double epoch);
+    void simulate(Tick first, double ticksPerSecond);
+    void cull(Frustum const & frustum);
+    void selectLevels(glm::vec3 const & eye, float pixelsPerUnit);
+    void submitBodies(glm::vec3 const & eye);
+    void drawFeedback();
+    void drawSkybox();
+
+    // Layout of the std140 Camera Uniform Block
+    struct CameraBlock
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+    };
+
+    // Shader Programs
+    Mirage::Shader mPlanetShader;
+    Mirage::Shader mSkyboxShader;
+    Mirage::Shader mSunShader;
+    Mirage::Shader mVirtualPlanetShader;
+    Mirage::Shader mVirtualSunShader;
+    Mirage::Shader mFeedbackShader;
+
+    // What the Scene Is Made Of, Its Bodies and the Model Drawn for Each of
+    // Them, Null for Spheres
+    SceneFile mScene;
+    BodyTable mBodies;
+    std::vector<std::unique_ptr<Model>> mModels;
+    int mSun;
+
+    // Sphere Meshes Shared by the Other Bodies, the Textures of Each Distinct
+    // Map, and the Map and Current Level of Detail of Each Body, -1 for Models
+    std::unique_ptr<Icosphere> mSphere;
+    std::vector<std::vector<Mirage::Texture>> mSurfaces;
+    std::vector<int> mSurfaceOf;
+    std::vector<int> mLevels;
+
+    // Maps Drawn From Tiles, and the Id of Each Map Among Them, or -1
+    std::unique_ptr<Mirage::VirtualTextures> mVirtual;
+    std::vector<int> mVirtualMaps;
+
+    // Mesh Draws, Sorted by State, and the Queue Ids of What Bodies Are
+    // Drawn With: Each Model Mesh and Its Material, or Each Sphere Level
+    // and Each Map
+    struct Part
+    {
+        RenderQueue::Id mesh;
+        RenderQueue::Id material;
+    };
+    RenderQueue mQueue;
+    RenderQueue::Id mPlanetProgram;
+    RenderQueue::Id mSunProgram;
+    RenderQueue::Id mVirtualPlanetProgram;
+    RenderQueue::Id mVirtualSunProgram;
+    std::vector<std::vector<Part>> mParts;
+    RenderQueue::Id mSphereMeshes[Icosphere::Levels];
+    std::vector<RenderQueue::Id> mSurfaceMaterials;
+
+    // Orbits, Evaluated in Kilometers Then Scaled Into the Scene, Read From
+    // the Ephemeris Where It Covers the Date
+    KeplerPropagator mOrbits;
+    Ephemeris mEphemeris;
+    std::vector<double> mX;
+    std::vector<double> mY;
+    std::vector<double> mZ;
+    std::vector<float> mOffsets;
+    std::vector<glm::vec3> mPositions;
+    double mEpoch;
+    std::atomic<double> mTimeWarp;
+    float  mTime;
+    bool   mStarted;
+
+    // Gravity Mode: the Engine, Whose First Ids Are the Bodies, the Date It
+    // Has Reached, Its Particles as Drawn and the Populations They Belong To
+    std::unique_ptr<NBodyEngine> mGravity;
+    double mGravityEpoch;
+    std::vector<int> mPopulation;
+    std::vector<glm::vec3> mParticles;
+    std::unique_ptr<ParticleCloud> mCloud;
+
+    // Simulation Thread, the Ticks It Publishes, and the Clock Both Sides
+    // Measure Tick Times On; a Pending Seek Is a Date, Otherwise Negative
+    std::thread mSimulation;
+    std::atomic<bool> mRunning;
+    std::atomic<double> mSeek;
+    TripleBuffer<Ticks> mTicks;
+    std::chrono::steady_clock::time_point mOrigin;
+    double mTickLength;
+
+    // Per-Frame Camera Uniforms
+    GLuint mCameraBuffer;
+
+    // World Bounds of Every Body, Their Hierarchy Once There Are Many, and
+    // Which Bodies Passed the Frustum Test This Frame
+    std::vector<float> mBoundX;
+    std::vector<float> mBoundY;
+    std::vector<float> mBoundZ;
+    std::vector<float> mBoundRadius;
+    std::vector<Mirage::Sphere> mBounds;
+    BoundingVolumeHierarchy mBodyTree;
+    std::vector<BoundingVolumeHierarchy::Range> mBodyRuns;
+    int mTreeAge;
+    std::vector<std::uint8_t> mVisible;
+    CullCounters mCounters;
+
+    // Main Belt, Absent When Empty
+    std::unique_ptr<AsteroidBelt> mBelt;
+
+    // Skybox Geometry
+    GLuint mSkyboxVAO;
+    GLuint mSkyboxVBO;
+    GLuint mCubemap;
+
+    // Orbit Tracks, Tessellated by Their Size on Screen
+    std::unique_ptr<OrbitTracks> mTracks;
+    std::vector<glm::dvec3> mTrackSamples;
+};
+
+// Loads the six faces of a cubemap texture: returns its handle at once and
+// decodes the faces on the loader's workers; they are uploaded by the time
+// loader.finish() returns.
+unsigned int loadCubemap(std::vector<std::string> faces, Mirage::AssetLoader & loader);
+
+#endif //~ Solar System Header
@@ -0,0 +1,72 @@
+// Preprocessor Directives
+#ifndef STREAM_BUFFER
+#define STREAM_BUFFER
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+// Sample Headers
+#include <gl_object.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <vector>
+
+// A buffer object rewritten every frame, split into regions that are used in
+// turn, so the CPU fills one while the GPU may still be reading the frames
+// before it. With GL 4.4 the buffer is mapped once, persistently and
+// coherently, and writing is a plain store into mapped memory. A fence after
+// each frame's draws guards its region until the GPU is done with it, which
+// with three regions has almost always happened. Older contexts write into a
+// copy on the CPU, uploaded with one glBufferSubData per frame.
+class StreamBuffer
+{
+public:
+
+    static const int Regions = 3;
+
+    explicit StreamBuffer(GLenum target);
+    ~StreamBuffer();
+
+    // Starts the next region with room for at least the given bytes and
+    // returns where to write. Regions grow as needed, which replaces the
+    // buffer object.
+    void * begin(std::size_t bytes);
+
+    // Makes the first bytes written visible to the GL; to be called before
+    // the draws that read them.
+    void flush(std::size_t bytes);
+
+    // Fences the region once the draws that read it are issued.
+    void end();
+
+    GLuint buffer() const { return mBuffer.get(); }
+    std::size_t size() const { return mRegionBytes * Regions; }
+
+    // Start of the current region in the buffer, in bytes.
+    std::size_t offset() const { return mRegion * mRegionBytes; }
+
+    // Whether the buffer is persistently mapped.
+    static bool persistent();
+
+private:
+
+    // Disable Copying and Assignment
+    StreamBuffer(StreamBuffer const &) = delete;
+    StreamBuffer & operator=(StreamBuffer const &) = delete;
+
+    // Private Member Functions
+    void allocate(std::size_t regionBytes);
+
+    // Private Member Variables
+    GLenum mTarget;
+    Mirage::Buffer mBuffer;
+    std::size_t mRegionBytes;
+    std::size_t mRegion;
+    unsigned char * mMapped;
+    std::vector<unsigned char> mStaging;
+    GLsync mFences[Regions];
+};
+
+#endif //~ Stream Buffer Header
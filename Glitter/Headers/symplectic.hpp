@@ -0,0 +1,85 @@
+// Preprocessor Directives
+#ifndef SYMPLECTIC
+#define SYMPLECTIC
+#pragma once
+
+// Local Headers
+#include "nbody.hpp"
+
+// System Headers
+#include <glm/glm.hpp>
+
+// Standard Headers
+#include <cstddef>
+#include <vector>
+
+// Bodies around a dominant central mass, in astronomical units, days and
+// solar masses, stepped by a symplectic map so that energy errors stay
+// bounded over millions of steps instead of growing. State is kept as
+// structure-of-arrays doubles in democratic heliocentric coordinates:
+// positions relative to the central mass, velocities relative to the
+// barycenter. Massless bodies feel the others but pull on nothing, so a
+// large population costs one pass over the massive bodies per particle.
+//
+// Two maps share that state. Velocity Verlet kicks with every force,
+// central one included, and drifts in between. Wisdom-Holman drifts each
+// body along its Kepler orbit about the central mass, solved exactly, and
+// kicks only with the small mutual pulls, so it takes far longer steps for
+// the same error. With AVX2 enabled the kicks run four bodies at a time.
+class SymplecticIntegrator
+{
+public:
+
+    enum Method
+    {
+        VelocityVerlet,
+        WisdomHolman,
+    };
+
+    explicit SymplecticIntegrator(double centralMass = 1.0);
+
+    // Appends a body by its position and velocity relative to the central
+    // mass and returns its index.
+    std::size_t add(double mass, glm::dvec3 const & position, glm::dvec3 const & velocity);
+
+    // Advances every body by dt days.
+    void step(double dt, Method method);
+
+    // Total energy of the central mass and the massive bodies, in solar
+    // masses times square astronomical units per square day.
+    double energy();
+
+    // State of a body relative to the central mass.
+    glm::dvec3 position(std::size_t i) const;
+    glm::dvec3 velocity(std::size_t i) const;
+
+    std::size_t size() const { return mMass.size(); }
+    std::size_t massive() const { return mMassive.size(); }
+
+    // Whether the kicks were built with their AVX2 kernel.
+    static bool vectorized();
+
+private:
+
+    // Private Member Functions
+    void barycentric();
+    glm::dvec3 centralVelocity() const;
+    void gather(bool central);
+    void kick(double dt);
+    void drift(double dt);
+    void jump(double dt);
+    void kepler(double dt);
+
+    // Private Member Variables
+    double mCentralMass;
+    std::vector<double> mX, mY, mZ;
+    std::vector<double> mVX, mVY, mVZ;
+    std::vector<double> mMass;
+    std::vector<std::size_t> mMassive;
+    bool mBarycentric; // velocities are barycentric, else heliocentric as added
+
+    // The pulling bodies, gathered for the kick: position and G times mass
+    std::vector<double> mPX, mPY, mPZ, mPGM;
+};
+
+#endif //~ Symplectic Header
@@ -0,0 +1,61 @@
+// Preprocessor Directives
+#ifndef TRIPLE_BUFFER
+#define TRIPLE_BUFFER
+#pragma once
+
+// Standard Headers
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without locks or
+// waiting. Each side owns one of three slots and the third sits between
+// them: the writer fills its slot and swaps it for the middle one, and the
+// reader swaps its slot for the middle one when a newer value is there. The
+// reader always sees the latest complete value and the writer never blocks,
+// however fast or slow the other side is. Slots are reused, so values that
+// hold memory keep their capacity from one write to the next.
+template <typename T>
+class TripleBuffer
+{
+public:
+
+    TripleBuffer() : mFront(0), mMiddle(1), mBack(2) {}
+
+    // Writer: the slot to fill, then publish it.
+    T & back() { return mSlots[mBack]; }
+    void publish()
+    {
+        mBack = mMiddle.exchange(mBack | Fresh, std::memory_order_acq_rel) & Index;
+    }
+
+    // Reader: takes the newest published value, if there is one since the
+    // last call, and returns whether it did.
+    bool update()
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & Fresh) == 0)
+            return false;
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & Index;
+        return true;
+    }
+    T const & front() const { return mSlots[mFront]; }
+
+    // Every slot, for sizing them before the threads start.
+    T & slot(int index) { return mSlots[index]; }
+
+private:
+
+    // Disable Copying and Assignment
+    TripleBuffer(TripleBuffer const &) = delete;
+    TripleBuffer & operator=(TripleBuffer const &) = delete;
+
+    // The middle slot's index, with a flag set while it holds an unread value
+    static const unsigned Index = 3;
+    static const unsigned Fresh = 4;
+
+    // Private Member Variables
+    T mSlots[3];
+    unsigned mFront;
+    std::atomic<unsigned> mMiddle;
+    unsigned mBack;
+};
+
+#endif //~ Triple Buffer Header
@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec4 Tint; // Per-instance base color
+
+uniform vec3 lightPos; // Position of the light source
+
+void main()
+{
+    // Same lighting as shader.frag, with the tint in place of the diffuse texture
+    vec3 ambient = 0.1 * Tint.rgb;
+    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 normal = normalize(Normal);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = diff * Tint.rgb;
+
+    FragColor = vec4(ambient + diffuse, Tint.a);
+}
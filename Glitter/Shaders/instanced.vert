@@ -0,0 +1,48 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 7) in mat4 aInstance;
+layout (location = 11) in vec4 aTint;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec4 Tint;
+
+uniform mat4 model;
+
+// Compact meshes store quantized positions and octahedral normals
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+        return n;
+    n = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 position = aPos * positionScale + positionOffset;
+
+    // Each instance is placed by its own transform, then the whole set by the model matrix
+    mat4 world = model * aInstance;
+
+    Tint = aTint;
+    FragPos = vec3(world * vec4(position, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+
+    // Instances only rotate and scale uniformly, so the normal needs no inverse
+    Normal = mat3(world) * decodeNormal(aNormal);
+}
@@ -3,9 +3,10 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D texture_diffuse1;
+// The map, from surface.frag or virtual_surface.frag
+vec4 surface(vec2 uv);
 
 void main()
 {
-    FragColor = texture(texture_diffuse1, TexCoords);
+    FragColor = surface(TexCoords);
 }
\ No newline at end of file
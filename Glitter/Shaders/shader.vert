@@ -2,23 +2,53 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 12) in uint aObject;
 
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-draw model and normal matrices, seven texels an object, written by the
+// render queue
+uniform samplerBuffer objects;
+
+// Compact meshes store quantized positions and octahedral normals
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+        return n;
+    n = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
 
 void main()
 {
+    int base = int(aObject) * 7;
+    mat4 model = mat4(texelFetch(objects, base), texelFetch(objects, base + 1),
+                      texelFetch(objects, base + 2), texelFetch(objects, base + 3));
+    mat3 normalMatrix = mat3(texelFetch(objects, base + 4).xyz, texelFetch(objects, base + 5).xyz,
+                             texelFetch(objects, base + 6).xyz);
+    vec3 position = aPos * positionScale + positionOffset;
+
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 
     // Calculate the world space position of the vertex
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(model * vec4(position, 1.0));
 
     // Calculate the normal in world space
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * decodeNormal(aNormal);
 }
@@ -0,0 +1,8 @@
+#version 330 core
+
+uniform sampler2D texture_diffuse1;
+
+vec4 surface(vec2 uv)
+{
+    return texture(texture_diffuse1, uv);
+}
@@ -4,8 +4,11 @@ layout (location = 0) in vec3 aPos;
 out vec3 Color;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
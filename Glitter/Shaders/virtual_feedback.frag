@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) out uvec4 Feedback;
+
+in vec2 TexCoords;
+
+// The map drawn, and its width and height in texels, its number of levels
+// and log2 of how much smaller the feedback is than the screen
+uniform int virtualMap;
+uniform vec4 virtualLayout;
+
+const float TileSize = 128.0;
+
+void main()
+{
+    // The level virtual_surface.frag will pick at full resolution
+    vec2 size = virtualLayout.xy;
+    vec2 dx = dFdx(TexCoords * size), dy = dFdy(TexCoords * size);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0)) - virtualLayout.w;
+    int level = min(int(max(lod, 0.0) + 0.5), int(virtualLayout.z) - 1);
+
+    vec2 st = vec2(fract(TexCoords.x), clamp(TexCoords.y, 0.0, 0.99999));
+    vec2 pages = max(floor(size / (TileSize * exp2(float(level)))), vec2(1.0));
+    uvec2 page = uvec2(min(st * pages, pages - 1.0));
+    Feedback = uvec4(uint(virtualMap), uint(level), page);
+}
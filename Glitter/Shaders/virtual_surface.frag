@@ -0,0 +1,32 @@
+#version 330 core
+
+// A map in virtual texture tiles; see Mirage::VirtualTextures and TileFile
+uniform usampler2D virtual_pages;
+uniform sampler2D virtual_atlas;
+
+const float TileSize = 128.0;
+const float Border = 4.0;
+const float Stride = TileSize + 2.0 * Border;
+
+vec4 surface(vec2 uv)
+{
+    // The level a mip-mapped texture of the whole map would use here
+    ivec2 tiles = textureSize(virtual_pages, 0);
+    vec2 size = vec2(tiles) * TileSize;
+    vec2 dx = dFdx(uv * size), dy = dFdy(uv * size);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+    int levels = int(log2(float(max(tiles.x, tiles.y))) + 1.5);
+    int level = min(int(lod + 0.5), levels - 1);
+
+    // Around the sphere, clamped at the poles
+    vec2 st = vec2(fract(uv.x), clamp(uv.y, 0.0, 0.99999));
+    ivec2 pages = textureSize(virtual_pages, level);
+    uvec4 entry = texelFetch(virtual_pages, min(ivec2(st * vec2(pages)), pages - 1), level);
+
+    // Where the point falls in the tile mapped, which is a coarser one when
+    // the tile of this level is not resident yet
+    vec2 texel = st * max(size / exp2(float(entry.z)), vec2(1.0));
+    vec2 inTile = texel - floor(texel / TileSize) * TileSize;
+    vec2 atlas = vec2(entry.xy) * Stride + Border + inTile;
+    return textureLod(virtual_atlas, atlas / vec2(textureSize(virtual_atlas, 0)), 0.0);
+}
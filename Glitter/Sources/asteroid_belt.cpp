@@ -0,0 +1,132 @@
+// Local Headers
+#include "asteroid_belt.hpp"
+
+// System Headers
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Standard Headers
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Rocks per leaf of the cluster hierarchy: small enough to cull most of an
+// off-screen belt, large enough that each visible run is still a big draw.
+static const std::size_t clusterSize = 256;
+
+// Builds a lumpy icosahedron of roughly unit radius; twenty triangles keep
+// even a very large belt cheap to draw.
+static Mirage::Mesh * makeRock(std::mt19937 & random)
+{
+    const float t = 1.61803398875f;
+    glm::vec3 corners[12] = {
+        {-1.0f,  t, 0.0f}, { 1.0f,  t, 0.0f}, {-1.0f, -t, 0.0f}, { 1.0f, -t, 0.0f},
+        { 0.0f, -1.0f,  t}, { 0.0f,  1.0f,  t}, { 0.0f, -1.0f, -t}, { 0.0f,  1.0f, -t},
+        {  t, 0.0f, -1.0f}, {  t, 0.0f,  1.0f}, { -t, 0.0f, -1.0f}, { -t, 0.0f,  1.0f},
+    };
+    const unsigned int faces[20][3] = {
+        {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9},  {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4},  {3, 4, 2},  {3, 2, 6},   {3, 6, 8},  {3, 8, 9},
+        {4, 9, 5},  {2, 4, 11}, {6, 2, 10},  {8, 6, 7},  {9, 8, 1},
+    };
+
+    std::uniform_real_distribution<float> lumps(0.75f, 1.15f);
+    for (auto & corner : corners)
+        corner = glm::normalize(corner) * lumps(random);
+
+    // Shared corners keep the vertex work per rock to twelve vertices, which
+    // dominates the cost of a large belt on a software rasterizer
+    std::vector<Mirage::Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (auto const & corner : corners)
+    {
+        Mirage::Vertex vertex = {};
+        vertex.Position = corner;
+        vertex.Normal = glm::normalize(corner);
+        vertices.push_back(vertex);
+    }
+    for (auto const & face : faces)
+        indices.insert(indices.end(), face, face + 3);
+    return new Mirage::Mesh(vertices, indices, std::vector<Mirage::Texture>());
+}
+
+AsteroidBelt::AsteroidBelt(RenderQueue & queue, int count, float innerRadius, float outerRadius, unsigned int seed)
+        : mInstances(0)
+        , mLightPos(0.0f)
+        , mCount(count)
+        , mDrawn(0)
+{
+    mShader.attach("instanced.vert");
+    mShader.attach("instanced.frag");
+    mShader.link();
+
+    std::mt19937 random(seed);
+    mRock.reset(makeRock(random));
+    mProgram = queue.program(mShader, "asteroids", [this](Mirage::Shader & shader) { shader.bind("lightPos", mLightPos); });
+    mMaterial = queue.material(mRock->textures);
+    mMesh = queue.mesh(*mRock);
+
+    // Uniform over the ring's area, thicker towards the outside, in grey-brown tones
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> height(0.0f, 0.02f);
+    std::vector<Mirage::Instance> instances(count);
+    for (auto & instance : instances)
+    {
+        float radius = std::sqrt(glm::mix(innerRadius * innerRadius, outerRadius * outerRadius, unit(random)));
+        float angle = glm::two_pi<float>() * unit(random);
+        glm::vec3 position(radius * std::cos(angle), radius * height(random), radius * std::sin(angle));
+        glm::vec3 axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f + 1e-3f);
+        float size = glm::mix(0.1f, 0.6f, unit(random) * unit(random));
+
+        instance.transform = glm::translate(glm::mat4(1.0f), position);
+        instance.transform = glm::rotate(instance.transform, glm::two_pi<float>() * unit(random), axis);
+        instance.transform = glm::scale(instance.transform, glm::vec3(size));
+        float shade = glm::mix(0.35f, 0.7f, unit(random));
+        instance.tint = glm::vec4(shade, shade * 0.9f, shade * 0.8f, 1.0f);
+    }
+
+    // Cluster the rocks and store them cluster by cluster
+    std::vector<Mirage::Sphere> bounds(instances.size());
+    Mirage::Sphere const & rock = mRock->bounds();
+    for (std::size_t i = 0; i < instances.size(); i++)
+    {
+        glm::mat4 const & transform = instances[i].transform;
+        bounds[i].center = glm::vec3(transform * glm::vec4(rock.center, 1.0f));
+        bounds[i].radius = rock.radius * glm::length(glm::vec3(transform[0]));
+    }
+    mClusters.build(bounds, clusterSize);
+    std::vector<Mirage::Instance> ordered(instances.size());
+    for (std::size_t i = 0; i < instances.size(); i++)
+        ordered[i] = instances[mClusters.order()[i]];
+
+    glGenBuffers(1, &mInstances);
+    glBindBuffer(GL_ARRAY_BUFFER, mInstances);
+    glBufferData(GL_ARRAY_BUFFER, ordered.size() * sizeof(Mirage::Instance), ordered.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+AsteroidBelt::~AsteroidBelt()
+{
+    glDeleteBuffers(1, &mInstances);
+}
+
+void AsteroidBelt::submit(RenderQueue & queue, Frustum const & frustum, glm::vec3 const & lightPos, float angle)
+{
+    mDrawn = 0;
+    if (mCount == 0)
+        return;
+
+    // Test the clusters in the ring's own frame rather than moving them all
+    glm::mat4 model = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    mRuns.clear();
+    mClusters.query(frustum.local(model), mRuns);
+
+    mLightPos = lightPos;
+    for (auto const & run : mRuns)
+    {
+        queue.submit(mProgram, mMaterial, mMesh, model, 0.0f,
+                     mInstances, static_cast<GLsizei>(run.count), static_cast<GLsizei>(run.first));
+        mDrawn += static_cast<int>(run.count);
+    }
+}
@@ -0,0 +1,156 @@
+// Local Headers
+#include "benchmark.hpp"
+
+// System Headers
+#include <glm/gtc/constants.hpp>
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+
+// Nearest-rank percentile of an unsorted series.
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+FrameTimer::FrameTimer()
+{
+    glGenQueries(1, & mQuery);
+}
+
+FrameTimer::~FrameTimer()
+{
+    glDeleteQueries(1, & mQuery);
+}
+
+void FrameTimer::begin()
+{
+    mStart = std::chrono::steady_clock::now();
+    glBeginQuery(GL_TIME_ELAPSED, mQuery);
+}
+
+void FrameTimer::end()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    auto submitted = std::chrono::steady_clock::now();
+    glFinish();
+    auto finished = std::chrono::steady_clock::now();
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(mQuery, GL_QUERY_RESULT, & elapsed);
+    mCpu.push_back(std::chrono::duration<double, std::milli>(submitted - mStart).count());
+    mGL.push_back(elapsed / 1.0e6);
+    mFinish.push_back(std::chrono::duration<double, std::milli>(finished - submitted).count());
+    mFrame.push_back(std::chrono::duration<double, std::milli>(finished - mStart).count());
+}
+
+void FrameTimer::report(FILE * stream) const
+{
+    fprintf(stream, "%-8s %10s %10s %10s\n", "[ms]", "p50", "p95", "p99");
+    fprintf(stream, "%-8s %10.3f %10.3f %10.3f\n", "cpu",
+            percentile(mCpu, 50), percentile(mCpu, 95), percentile(mCpu, 99));
+    fprintf(stream, "%-8s %10.3f %10.3f %10.3f\n", "gl",
+            percentile(mGL, 50), percentile(mGL, 95), percentile(mGL, 99));
+    fprintf(stream, "%-8s %10.3f %10.3f %10.3f\n", "finish",
+            percentile(mFinish, 50), percentile(mFinish, 95), percentile(mFinish, 99));
+    fprintf(stream, "%-8s %10.3f %10.3f %10.3f\n", "frame",
+            percentile(mFrame, 50), percentile(mFrame, 95), percentile(mFrame, 99));
+}
+
+void runBenchmark(SolarSystem & scene, Camera & camera, int frames)
+{
+    const int   warmup   = 10;
+    const float timeStep = 1.0f / 60.0f;
+
+    fprintf(stderr, "Benchmark: %d frames at %dx%d on %s\n", frames, mWidth, mHeight, glGetString(GL_RENDERER));
+    fprintf(stderr, "Models: %zu KiB on the CPU, %zu KiB on the GPU\n",
+            scene.cpuBytes() / 1024, scene.gpuBytes() / 1024);
+    fprintf(stderr, "Textures: %zu cached, %zu KiB\n",
+            Mirage::TextureCache::global().size(), Mirage::TextureCache::global().bytes() / 1024);
+
+    FrameTimer timer;
+    double drawn = 0.0, culled = 0.0, rocksDrawn = 0.0, rocksCulled = 0.0, triangles = 0.0;
+    double segments = 0.0, uploads = 0.0;
+    double draws = 0.0, calls = 0.0, programs = 0.0, materials = 0.0, vertexArrays = 0.0;
+    double build = 0.0, forces = 0.0, interactions = 0.0;
+    double tileUploads = 0.0;
+    for (int i = -warmup; i < frames; i++)
+    {
+        // Circle the Sun once over the run, bobbing above and below the ecliptic
+        float t = static_cast<float>(std::max(i, 0)) / frames;
+        float angle = glm::two_pi<float>() * t;
+        camera.Position = glm::vec3(600.0f * cos(angle), 150.0f * sin(2.0f * angle), 600.0f * sin(angle));
+        camera.LookAt(glm::vec3(0.0f, 0.0f, 0.0f));
+
+        if (i < 0)
+        {
+            if (scene.simulating()) scene.interpolate();
+            else scene.update(0.0f);
+            scene.draw(camera);
+            glFinish();
+            Mirage::Profiler::global().frame();
+            continue;
+        }
+
+        timer.begin();
+        if (scene.simulating()) scene.interpolate();
+        else scene.update(i * timeStep);
+        scene.draw(camera);
+        timer.end();
+        Mirage::Profiler::global().frame();
+
+        SolarSystem::CullCounters const & counters = scene.counters();
+        drawn += counters.bodiesDrawn;
+        culled += counters.bodiesCulled;
+        rocksDrawn += counters.rocksDrawn;
+        rocksCulled += counters.rocksCulled;
+        triangles += counters.sphereTriangles;
+        segments += counters.trackSegments;
+        uploads += counters.trackUploads;
+
+        RenderQueue::Stats const & queue = scene.queueStats();
+        draws += queue.draws;
+        calls += queue.calls;
+        programs += queue.programs;
+        materials += queue.materials;
+        vertexArrays += queue.vertexArrays;
+        if (scene.virtualTextures())
+            tileUploads += scene.virtualTextures()->stats().uploads;
+
+        // The last step's timings, unless the simulation thread may be writing them
+        if (scene.gravity() && !scene.simulating())
+        {
+            NBodyEngine::Stats const & stats = scene.gravity()->stats();
+            build += stats.build;
+            forces += stats.forces;
+            interactions += static_cast<double>(stats.interactions);
+        }
+    }
+    if (frames > 0)
+        fprintf(stderr, "Culling per frame: %.1f bodies drawn, %.1f culled; %.0f rocks drawn, %.0f culled\n",
+                drawn / frames, culled / frames, rocksDrawn / frames, rocksCulled / frames);
+    if (frames > 0)
+        fprintf(stderr, "Sphere detail per frame: %.0f triangles\n", triangles / frames);
+    if (frames > 0)
+        fprintf(stderr, "Orbit tracks per frame: %.0f segments, %.2f tracks re-uploaded\n",
+                segments / frames, uploads / frames);
+    if (frames > 0)
+        fprintf(stderr, "Render queue per frame: %.1f draws in %.1f calls, %.1f programs, %.1f materials, %.1f vertex arrays bound\n",
+                draws / frames, calls / frames, programs / frames, materials / frames, vertexArrays / frames);
+    if (frames > 0 && scene.virtualTextures())
+    {
+        Mirage::VirtualTextures const & tiles = *scene.virtualTextures();
+        fprintf(stderr, "Virtual textures: %zu maps, %d of %d tiles resident, %zu KiB; %.2f uploads per frame\n",
+                tiles.size(), tiles.stats().resident, tiles.capacity(), tiles.gpuBytes() / 1024, tileUploads / frames);
+    }
+    if (frames > 0 && scene.gravity() && !scene.simulating())
+        fprintf(stderr, "Gravity: %zu particles on %u threads; last step per frame: %.3f ms build, %.3f ms forces, %.0f interactions\n",
+                scene.gravity()->size(), scene.gravity()->threads(), build / frames, forces / frames, interactions / frames);
+    timer.report(stdout);
+    if (Mirage::Profiler::global().enabled())
+        Mirage::Profiler::global().report(stdout);
+}
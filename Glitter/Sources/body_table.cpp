@@ -0,0 +1,228 @@
+// Local Headers
+#include "body_table.hpp"
+
+// System Headers
+#include <glm/gtc/matrix_transform.hpp>
+
+// Standard Headers
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BODY_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Cody-Waite split of pi/2 and the minimax polynomials for sin and cos on
+// [-pi/4, pi/4] from Cephes; accurate to about 1e-7 for |x| up to 1e5.
+static const float twoOverPi = 0.636619772367581343f;
+static const float halfPi1   = 1.5703125f;
+static const float halfPi2   = 4.837512969970703125e-4f;
+static const float halfPi3   = 7.54978995489188216e-8f;
+static const float sin1 = -1.6666654611e-1f, sin2 = 8.3321608736e-3f, sin3 = -1.9515295891e-4f;
+static const float cos1 = 4.166664568298827e-2f, cos2 = -1.388731625493765e-3f, cos3 = 2.443315711809948e-5f;
+
+static inline void sincos1(float x, float & s, float & c)
+{
+    int   q = static_cast<int>(std::lrint(x * twoOverPi));
+    float y = ((x - q * halfPi1) - q * halfPi2) - q * halfPi3;
+    float z = y * y;
+    float ps = y + y * z * (sin1 + z * (sin2 + z * sin3));
+    float pc = 1.0f - 0.5f * z + z * z * (cos1 + z * (cos2 + z * cos3));
+    s = (q & 1) ? pc : ps;
+    c = (q & 1) ? ps : pc;
+    if (q & 2)       s = -s;
+    if ((q + 1) & 2) c = -c;
+}
+
+static inline float wrap1(float x)
+{
+    const float twoPi = 6.28318530717958647692f;
+    return x - twoPi * std::nearbyint(x * (1.0f / twoPi));
+}
+
+#if defined(BODY_TABLE_SSE2)
+static inline void sincos4(__m128 x, __m128 & s, __m128 & c)
+{
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(twoOverPi)));
+    __m128  k = _mm_cvtepi32_ps(q);
+    __m128  y = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(halfPi1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(k, _mm_set1_ps(halfPi2)));
+    y = _mm_sub_ps(y, _mm_mul_ps(k, _mm_set1_ps(halfPi3)));
+    __m128 z = _mm_mul_ps(y, y);
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(sin3)), _mm_set1_ps(sin2));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(sin1));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), y), y);
+    __m128 pc = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(cos3)), _mm_set1_ps(cos2));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(cos1));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // Odd quadrants swap sin and cos, the sign bits follow from bit 1
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps)), sinSign);
+    c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc)), cosSign);
+}
+
+static inline __m128 wrap4(__m128 x)
+{
+    const float twoPi = 6.28318530717958647692f;
+    __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / twoPi))));
+    return _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(twoPi)));
+}
+#endif
+
+int BodyTable::add(Body const & body)
+{
+    // Precompute the tilt rotation; the spin rotation changes every update
+    glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), body.tilt, body.tiltAxis);
+    glm::vec3 axis = glm::normalize(body.spinAxis);
+
+    mParent.push_back(body.parent);
+    mOffsetX.push_back(0.0f);
+    mOffsetY.push_back(0.0f);
+    mOffsetZ.push_back(0.0f);
+    mSpinRate.push_back(body.spinRate);
+    mSpinAxisX.push_back(axis.x);
+    mSpinAxisY.push_back(axis.y);
+    mSpinAxisZ.push_back(axis.z);
+    for (int col = 0; col < 3; col++)
+    for (int row = 0; row < 3; row++)
+        mTilt[col * 3 + row].push_back(tilt[col][row]);
+    mScale.push_back(body.scale);
+    mModels.push_back(glm::mat4(1.0f));
+    mNormals.push_back(glm::mat3x4(1.0f));
+
+    int index = static_cast<int>(mScale.size()) - 1;
+    if (body.parent >= 0) mSatellites.push_back(index);
+    return index;
+}
+
+void BodyTable::setOffset(std::size_t i, glm::vec3 const & offset)
+{
+    mOffsetX[i] = offset.x;
+    mOffsetY[i] = offset.y;
+    mOffsetZ[i] = offset.z;
+}
+
+void BodyTable::update(float time)
+{
+    std::size_t count = size();
+    std::size_t i = 0;
+    if (count == 0) return;
+    float * models = &mModels[0][0][0];
+    float * normals = &mNormals[0][0][0];
+
+#if defined(BODY_TABLE_SSE2)
+    __m128 t = _mm_set1_ps(time);
+    for (; i + 4 <= count; i += 4)
+    {
+        // Spin matrix from the axis-angle (Rodrigues) formula, like glm::rotate
+        __m128 ss, sc;
+        sincos4(wrap4(_mm_mul_ps(t, _mm_loadu_ps(&mSpinRate[i]))), ss, sc);
+        __m128 ax = _mm_loadu_ps(&mSpinAxisX[i]);
+        __m128 ay = _mm_loadu_ps(&mSpinAxisY[i]);
+        __m128 az = _mm_loadu_ps(&mSpinAxisZ[i]);
+        __m128 k  = _mm_sub_ps(_mm_set1_ps(1.0f), sc);
+        __m128 kx = _mm_mul_ps(k, ax), ky = _mm_mul_ps(k, ay), kz = _mm_mul_ps(k, az);
+        __m128 r[9];
+        r[0] = _mm_add_ps(sc, _mm_mul_ps(kx, ax));
+        r[1] = _mm_add_ps(_mm_mul_ps(kx, ay), _mm_mul_ps(ss, az));
+        r[2] = _mm_sub_ps(_mm_mul_ps(kx, az), _mm_mul_ps(ss, ay));
+        r[3] = _mm_sub_ps(_mm_mul_ps(ky, ax), _mm_mul_ps(ss, az));
+        r[4] = _mm_add_ps(sc, _mm_mul_ps(ky, ay));
+        r[5] = _mm_add_ps(_mm_mul_ps(ky, az), _mm_mul_ps(ss, ax));
+        r[6] = _mm_add_ps(_mm_mul_ps(kz, ax), _mm_mul_ps(ss, ay));
+        r[7] = _mm_sub_ps(_mm_mul_ps(kz, ay), _mm_mul_ps(ss, ax));
+        r[8] = _mm_add_ps(sc, _mm_mul_ps(kz, az));
+
+        // Tilt * Spin * Scale, and the normal matrix Tilt * Spin / Scale
+        __m128 scale = _mm_loadu_ps(&mScale[i]);
+        __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), scale);
+        __m128 tilt[9];
+        for (int e = 0; e < 9; e++) tilt[e] = _mm_loadu_ps(&mTilt[e][i]);
+        __m128 m[9], n[9];
+        for (int col = 0; col < 3; col++)
+        for (int row = 0; row < 3; row++)
+        {
+            __m128 v = _mm_mul_ps(tilt[row], r[col * 3]);
+            v = _mm_add_ps(v, _mm_mul_ps(tilt[3 + row], r[col * 3 + 1]));
+            v = _mm_add_ps(v, _mm_mul_ps(tilt[6 + row], r[col * 3 + 2]));
+            m[col * 3 + row] = _mm_mul_ps(v, scale);
+            n[col * 3 + row] = _mm_mul_ps(v, inverse);
+        }
+
+        // Transpose four bodies' columns into four column-major matrices
+        __m128 zero = _mm_setzero_ps();
+        __m128 one  = _mm_set1_ps(1.0f);
+        __m128 cols[4][4] = {
+            { m[0], m[1], m[2], zero },
+            { m[3], m[4], m[5], zero },
+            { m[6], m[7], m[8], zero },
+            { _mm_loadu_ps(&mOffsetX[i]), _mm_loadu_ps(&mOffsetY[i]), _mm_loadu_ps(&mOffsetZ[i]), one },
+        };
+        for (int col = 0; col < 4; col++)
+        {
+            _MM_TRANSPOSE4_PS(cols[col][0], cols[col][1], cols[col][2], cols[col][3]);
+            for (int b = 0; b < 4; b++)
+                _mm_storeu_ps(models + (i + b) * 16 + col * 4, cols[col][b]);
+        }
+        for (int col = 0; col < 3; col++)
+        {
+            __m128 c0 = n[col * 3], c1 = n[col * 3 + 1], c2 = n[col * 3 + 2], c3 = zero;
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            _mm_storeu_ps(normals + (i + 0) * 12 + col * 4, c0);
+            _mm_storeu_ps(normals + (i + 1) * 12 + col * 4, c1);
+            _mm_storeu_ps(normals + (i + 2) * 12 + col * 4, c2);
+            _mm_storeu_ps(normals + (i + 3) * 12 + col * 4, c3);
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        float ss, sc;
+        sincos1(wrap1(time * mSpinRate[i]), ss, sc);
+
+        float ax = mSpinAxisX[i], ay = mSpinAxisY[i], az = mSpinAxisZ[i];
+        float k  = 1.0f - sc;
+        float r[9] = {
+            sc + k * ax * ax,      k * ax * ay + ss * az, k * ax * az - ss * ay,
+            k * ay * ax - ss * az, sc + k * ay * ay,      k * ay * az + ss * ax,
+            k * az * ax + ss * ay, k * az * ay - ss * ax, sc + k * az * az,
+        };
+
+        float * out = models + i * 16;
+        float * normal = normals + i * 12;
+        float inverse = 1.0f / mScale[i];
+        for (int col = 0; col < 3; col++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                float v = mTilt[row][i]     * r[col * 3]
+                        + mTilt[3 + row][i] * r[col * 3 + 1]
+                        + mTilt[6 + row][i] * r[col * 3 + 2];
+                out[col * 4 + row] = v * mScale[i];
+                normal[col * 4 + row] = v * inverse;
+            }
+            out[col * 4 + 3] = 0.0f;
+            normal[col * 4 + 3] = 0.0f;
+        }
+        out[12] = mOffsetX[i];
+        out[13] = mOffsetY[i];
+        out[14] = mOffsetZ[i];
+        out[15] = 1.0f;
+    }
+
+    // Move satellites along with their parents; parents always come first
+    for (int satellite : mSatellites)
+    {
+        glm::vec4 const & parent = mModels[mParent[satellite]][3];
+        glm::vec4 & position = mModels[satellite][3];
+        position.x += parent.x;
+        position.y += parent.y;
+        position.z += parent.z;
+    }
+}
@@ -0,0 +1,178 @@
+// Local Headers
+#include "culling.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+
+static glm::vec4 normalizePlane(glm::vec4 const & plane)
+{
+    return plane / glm::length(glm::vec3(plane));
+}
+
+Frustum::Frustum(glm::mat4 const & projectionView)
+{
+    // Each plane is the last row of the matrix plus or minus one of the others
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]);
+    for (int i = 0; i < 3; i++)
+    {
+        mPlanes[2 * i]     = normalizePlane(rows[3] + rows[i]);
+        mPlanes[2 * i + 1] = normalizePlane(rows[3] - rows[i]);
+    }
+}
+
+Frustum Frustum::local(glm::mat4 const & model) const
+{
+    // A plane p tests world points as dot(p, model * x), that is dot(transpose(model) * p, x)
+    Frustum frustum;
+    glm::mat4 transposed = glm::transpose(model);
+    for (int i = 0; i < 6; i++)
+        frustum.mPlanes[i] = normalizePlane(transposed * mPlanes[i]);
+    return frustum;
+}
+
+bool Frustum::visible(Mirage::Sphere const & sphere) const
+{
+    for (auto const & plane : mPlanes)
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    return true;
+}
+
+void Frustum::visible(float const * x, float const * y, float const * z, float const * radius,
+                      std::size_t count, std::uint8_t * result) const
+{
+    std::fill(result, result + count, std::uint8_t(1));
+    for (auto const & plane : mPlanes)
+        for (std::size_t i = 0; i < count; i++)
+        {
+            float distance = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w;
+            result[i] &= static_cast<std::uint8_t>(distance >= -radius[i]);
+        }
+}
+
+int Frustum::classify(glm::vec3 const & lower, glm::vec3 const & upper) const
+{
+    int result = 1;
+    for (auto const & plane : mPlanes)
+    {
+        // The corners furthest along and furthest against the plane normal
+        glm::vec3 inner(plane.x >= 0.0f ? upper.x : lower.x,
+                        plane.y >= 0.0f ? upper.y : lower.y,
+                        plane.z >= 0.0f ? upper.z : lower.z);
+        glm::vec3 outer(plane.x >= 0.0f ? lower.x : upper.x,
+                        plane.y >= 0.0f ? lower.y : upper.y,
+                        plane.z >= 0.0f ? lower.z : upper.z);
+        if (glm::dot(glm::vec3(plane), inner) + plane.w < 0.0f)
+            return -1;
+        if (glm::dot(glm::vec3(plane), outer) + plane.w < 0.0f)
+            result = 0;
+    }
+    return result;
+}
+
+void BoundingVolumeHierarchy::build(std::vector<Mirage::Sphere> const & items, std::size_t leafSize)
+{
+    mNodes.clear();
+    mOrder.resize(items.size());
+    for (std::size_t i = 0; i < items.size(); i++)
+        mOrder[i] = static_cast<std::uint32_t>(i);
+    if (!items.empty())
+        split(items, 0, static_cast<std::uint32_t>(items.size()), std::max<std::size_t>(leafSize, 1));
+}
+
+std::uint32_t BoundingVolumeHierarchy::split(std::vector<Mirage::Sphere> const & items, std::uint32_t first,
+                                             std::uint32_t count, std::size_t leafSize)
+{
+    std::uint32_t index = static_cast<std::uint32_t>(mNodes.size());
+    Node node = { glm::vec3(0.0f), first, glm::vec3(0.0f), count, 0 };
+    bound(node, items);
+    mNodes.push_back(node);
+    if (count <= leafSize)
+        return index;
+
+    // Halve along the longest extent of the item centers
+    glm::vec3 lower = items[mOrder[first]].center, upper = lower;
+    for (std::uint32_t i = first; i < first + count; i++)
+    {
+        lower = glm::min(lower, items[mOrder[i]].center);
+        upper = glm::max(upper, items[mOrder[i]].center);
+    }
+    glm::vec3 extent = upper - lower;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+    std::uint32_t half = count / 2;
+    std::nth_element(mOrder.begin() + first, mOrder.begin() + first + half, mOrder.begin() + first + count,
+                     [&items, axis](std::uint32_t a, std::uint32_t b) {
+                         return items[a].center[axis] < items[b].center[axis];
+                     });
+
+    split(items, first, half, leafSize);
+    std::uint32_t right = split(items, first + half, count - half, leafSize);
+    mNodes[index].right = right;
+    return index;
+}
+
+void BoundingVolumeHierarchy::bound(Node & node, std::vector<Mirage::Sphere> const & items) const
+{
+    Mirage::Sphere const & head = items[mOrder[node.first]];
+    node.lower = head.center - head.radius;
+    node.upper = head.center + head.radius;
+    for (std::uint32_t i = node.first + 1; i < node.first + node.count; i++)
+    {
+        Mirage::Sphere const & item = items[mOrder[i]];
+        node.lower = glm::min(node.lower, item.center - item.radius);
+        node.upper = glm::max(node.upper, item.center + item.radius);
+    }
+}
+
+void BoundingVolumeHierarchy::refit(std::vector<Mirage::Sphere> const & items)
+{
+    // Children always come after their parent, so walk back up from the end
+    for (std::size_t i = mNodes.size(); i-- > 0; )
+    {
+        Node & node = mNodes[i];
+        if (node.right == 0)
+        {
+            bound(node, items);
+            continue;
+        }
+        Node const & left = mNodes[i + 1];
+        Node const & right = mNodes[node.right];
+        node.lower = glm::min(left.lower, right.lower);
+        node.upper = glm::max(left.upper, right.upper);
+    }
+}
+
+void BoundingVolumeHierarchy::query(Frustum const & frustum, std::vector<Range> & ranges) const
+{
+    if (mNodes.empty())
+        return;
+
+    std::uint32_t stack[64];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        Node const & node = mNodes[stack[--depth]];
+        int side = frustum.classify(node.lower, node.upper);
+        if (side < 0)
+            continue;
+        if (side == 0 && node.right != 0)
+        {
+            // Visit the first child next, so that the runs come out in order
+            stack[depth++] = node.right;
+            stack[depth++] = static_cast<std::uint32_t>(&node - mNodes.data()) + 1;
+            continue;
+        }
+
+        if (!ranges.empty() && ranges.back().first + ranges.back().count == node.first)
+            ranges.back().count += node.count;
+        else
+        {
+            Range range = { node.first, node.count };
+            ranges.push_back(range);
+        }
+    }
+}
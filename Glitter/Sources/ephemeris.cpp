@@ -0,0 +1,275 @@
+// Local Headers
+#include "ephemeris.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+static const double pi = 3.14159265358979323846;
+
+static const char magic[8] = { 'M', 'I', 'R', 'E', 'P', 'H', 'E', 'M' };
+
+// Sub-intervals per record are tried in powers of two up to this many
+static const std::uint32_t maxSubintervals = 64;
+
+// On-Disk Layout: Header, One Layout per Body, Then From the Next 64-Byte
+// Boundary the Records, Each a Run of recordSize Doubles With No Padding
+struct FileHeader
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t bodyCount;
+    std::uint64_t key;
+    double        start;
+    double        span;
+    std::uint32_t recordCount;
+    std::uint32_t recordSize;
+    std::uint64_t recordOffset;
+};
+
+// Sums a Chebyshev series at u in [-1, 1] for three axes at once, their
+// coefficients stored one axis after the other (Clenshaw's recurrence).
+static glm::dvec3 clenshaw(double const * c, std::uint32_t count, double u)
+{
+    glm::dvec3 b1(0.0), b2(0.0);
+    for (std::uint32_t k = count - 1; k > 0; k--)
+    {
+        glm::dvec3 b0 = b1 * (2.0 * u) - b2 + glm::dvec3(c[k], c[count + k], c[2 * count + k]);
+        b2 = b1;
+        b1 = b0;
+    }
+    return b1 * u - b2 + glm::dvec3(c[0], c[count], c[2 * count]);
+}
+
+Ephemeris::Ephemeris()
+        : mLayouts(nullptr)
+        , mRecords(nullptr)
+        , mBodyCount(0)
+        , mRecordCount(0)
+        , mRecordSize(0)
+        , mStart(0.0)
+        , mSpan(1.0)
+{
+}
+
+bool Ephemeris::open(std::string const & path, std::uint64_t key)
+{
+    mLayouts = nullptr;
+    mRecords = nullptr;
+    if (!mFile.open(path)) return false;
+
+    // Reject anything that was not generated from the same data by this layout
+    auto data = mFile.data();
+    auto size = mFile.size();
+    FileHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(& header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+        || header.version != Version
+        || header.key != key
+        || header.bodyCount == 0
+        || header.recordCount == 0
+        || !(header.span > 0.0)
+        || header.bodyCount > (size - sizeof(header)) / sizeof(Layout)
+        || header.recordOffset % 64
+        || header.recordOffset > size
+        || std::uint64_t(header.recordCount) * header.recordSize > (size - header.recordOffset) / sizeof(double))
+        return false;
+
+    auto layouts = reinterpret_cast<Layout const *>(data + sizeof(header));
+    for (std::uint32_t i = 0; i < header.bodyCount; i++)
+    {
+        Layout const & layout = layouts[i];
+        if (layout.coefficients == 0 || layout.subintervals == 0
+            || std::uint64_t(layout.offset) + std::uint64_t(layout.subintervals) * 3 * layout.coefficients > header.recordSize)
+            return false;
+    }
+
+    mLayouts = layouts;
+    mRecords = reinterpret_cast<double const *>(data + header.recordOffset);
+    mBodyCount = header.bodyCount;
+    mRecordCount = header.recordCount;
+    mRecordSize = header.recordSize;
+    mStart = header.start;
+    mSpan = header.span;
+    return true;
+}
+
+glm::dvec3 Ephemeris::evaluate(Layout const & layout, double const * record, double fraction) const
+{
+    double scaled = fraction * layout.subintervals;
+    std::uint32_t sub = std::min(static_cast<std::uint32_t>(scaled), layout.subintervals - 1);
+    double u = 2.0 * (scaled - sub) - 1.0;
+    return clenshaw(record + layout.offset + std::size_t(sub) * 3 * layout.coefficients, layout.coefficients, u);
+}
+
+void Ephemeris::positions(double julianDate, double * x, double * y, double * z) const
+{
+    // One record holds every body at this date
+    double t = (julianDate - mStart) / mSpan;
+    std::uint32_t index = static_cast<std::uint32_t>(std::min(std::max(std::floor(t), 0.0), mRecordCount - 1.0));
+    double fraction = std::min(std::max(t - index, 0.0), 1.0);
+    double const * record = mRecords + std::size_t(index) * mRecordSize;
+    for (std::uint32_t body = 0; body < mBodyCount; body++)
+    {
+        glm::dvec3 position = evaluate(mLayouts[body], record, fraction);
+        x[body] = position.x;
+        y[body] = position.y;
+        z[body] = position.z;
+    }
+}
+
+glm::dvec3 Ephemeris::position(std::size_t body, double julianDate) const
+{
+    double t = (julianDate - mStart) / mSpan;
+    std::uint32_t index = static_cast<std::uint32_t>(std::min(std::max(std::floor(t), 0.0), mRecordCount - 1.0));
+    double fraction = std::min(std::max(t - index, 0.0), 1.0);
+    return evaluate(mLayouts[body], mRecords + std::size_t(index) * mRecordSize, fraction);
+}
+
+bool Ephemeris::generate(std::string const & path, std::uint64_t key, std::size_t bodies, Source const & source,
+                         double start, double end, double span, int coefficients, double tolerance, double * maxError)
+{
+    if (bodies == 0 || !(end > start) || !(span > 0.0) || coefficients < 2)
+        return false;
+    std::uint32_t records = static_cast<std::uint32_t>(std::ceil((end - start) / span));
+    std::uint32_t count = static_cast<std::uint32_t>(coefficients);
+
+    // Positions of every body at points of [from, to] given in [-1, 1], one
+    // call of the source per point, kept point after point
+    std::vector<double> x, y, z;
+    auto sample = [&](double from, double to, std::vector<double> const & points) {
+        std::size_t size = points.size() * bodies;
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+        for (std::size_t j = 0; j < points.size(); j++)
+            source(from + (points[j] + 1.0) * 0.5 * (to - from), & x[j * bodies], & y[j * bodies], & z[j * bodies]);
+    };
+    auto at = [&](std::size_t j, std::size_t body) {
+        std::size_t i = j * bodies + body;
+        return glm::dvec3(x[i], y[i], z[i]);
+    };
+
+    // Fits are sampled at the Chebyshev nodes, then checked at the points
+    // halfway between them in angle, which include both ends of the interval,
+    // or only at the middle once the sub-intervals are chosen
+    std::vector<double> probePoints, recordPoints;
+    for (std::uint32_t j = 0; j < count; j++)
+        probePoints.push_back(std::cos(pi * (j + 0.5) / count));
+    recordPoints = probePoints;
+    for (std::uint32_t j = 0; j <= count; j++)
+        probePoints.push_back(std::cos(pi * j / count));
+    recordPoints.push_back(0.0);
+
+    // Interpolates a body at the nodes last sampled, which comes within a
+    // small factor of the best polynomial of that degree
+    auto fit = [&](std::size_t body, double * c) {
+        for (std::uint32_t k = 0; k < count; k++)
+        {
+            glm::dvec3 sum(0.0);
+            for (std::uint32_t j = 0; j < count; j++)
+                sum += at(j, body) * std::cos(pi * k * (j + 0.5) / count);
+            sum = sum * ((k == 0 ? 1.0 : 2.0) / count);
+            c[k] = sum.x;
+            c[count + k] = sum.y;
+            c[2 * count + k] = sum.z;
+        }
+    };
+
+    // Largest error of a fit at the points last sampled after the nodes
+    auto error = [&](std::size_t body, double const * c, std::vector<double> const & points) {
+        double largest = 0.0;
+        for (std::size_t j = count; j < points.size(); j++)
+            largest = std::max(largest, glm::length(clenshaw(c, count, points[j]) - at(j, body)));
+        return largest;
+    };
+
+    // Pick each body's sub-intervals on a few records spread over the span,
+    // trying finer ones only for the bodies that still miss the tolerance
+    std::vector<Layout> layouts(bodies);
+    std::vector<std::uint32_t> chosen(bodies, 0);
+    std::vector<double> largest(bodies);
+    std::vector<double> scratch(3 * count);
+    std::uint32_t probes[] = { 0, records / 4, records / 2, records - records / 4 - 1, records - 1 };
+    std::size_t left = bodies;
+    for (std::uint32_t subintervals = 1; left > 0; subintervals *= 2)
+    {
+        std::fill(largest.begin(), largest.end(), 0.0);
+        for (auto probe : probes)
+            for (std::uint32_t sub = 0; sub < subintervals; sub++)
+            {
+                double from = start + span * (probe + double(sub) / subintervals);
+                double to = from + span / subintervals;
+                sample(from, to, probePoints);
+                for (std::size_t body = 0; body < bodies; body++)
+                    if (chosen[body] == 0)
+                    {
+                        fit(body, scratch.data());
+                        largest[body] = std::max(largest[body], error(body, scratch.data(), probePoints));
+                    }
+            }
+        for (std::size_t body = 0; body < bodies; body++)
+            if (chosen[body] == 0 && (largest[body] <= tolerance || subintervals == maxSubintervals))
+            {
+                chosen[body] = subintervals;
+                left--;
+            }
+    }
+
+    // Lay the bodies out, and group them by their sub-intervals so that each
+    // sub-interval of a record is sampled once for all the bodies that use it
+    std::map<std::uint32_t, std::vector<std::size_t>> groups;
+    std::uint32_t recordSize = 0;
+    for (std::size_t body = 0; body < bodies; body++)
+    {
+        layouts[body].offset = recordSize;
+        layouts[body].coefficients = count;
+        layouts[body].subintervals = chosen[body];
+        layouts[body].reserved = 0;
+        recordSize += chosen[body] * 3 * count;
+        groups[chosen[body]].push_back(body);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = Version;
+    header.bodyCount = static_cast<std::uint32_t>(bodies);
+    header.key = key;
+    header.start = start;
+    header.span = span;
+    header.recordCount = records;
+    header.recordSize = recordSize;
+    header.recordOffset = (sizeof(header) + bodies * sizeof(Layout) + 63) & ~std::uint64_t(63);
+
+    std::vector<unsigned char> buffer(header.recordOffset + std::size_t(records) * recordSize * sizeof(double), 0);
+    std::memcpy(buffer.data(), & header, sizeof(header));
+    std::memcpy(buffer.data() + sizeof(header), layouts.data(), bodies * sizeof(Layout));
+
+    // Fit every record, checking each sub-interval at its middle
+    double worst = 0.0;
+    double * output = reinterpret_cast<double *>(buffer.data() + header.recordOffset);
+    for (std::uint32_t record = 0; record < records; record++)
+        for (auto const & group : groups)
+        {
+            std::uint32_t subintervals = group.first;
+            for (std::uint32_t sub = 0; sub < subintervals; sub++)
+            {
+                double from = start + span * (record + double(sub) / subintervals);
+                double to = from + span / subintervals;
+                sample(from, to, recordPoints);
+                for (auto body : group.second)
+                {
+                    double * c = output + std::size_t(record) * recordSize + layouts[body].offset + std::size_t(sub) * 3 * count;
+                    fit(body, c);
+                    worst = std::max(worst, error(body, c, recordPoints));
+                }
+            }
+        }
+    if (maxError)
+        *maxError = worst;
+    return Mirage::replaceFile(path, buffer.data(), buffer.size());
+}
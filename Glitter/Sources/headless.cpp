@@ -0,0 +1,94 @@
+// Local Headers
+#include "headless.hpp"
+
+// Standard Headers
+#include <cstdio>
+
+#if defined(GLITTER_HEADLESS)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+HeadlessContext::HeadlessContext(int width, int height)
+        : mDisplay(EGL_NO_DISPLAY)
+        , mContext(EGL_NO_CONTEXT)
+        , mFramebuffer(0)
+        , mColorBuffer(0)
+        , mDepthBuffer(0)
+        , mValid(false)
+{
+    // Open the Surfaceless Platform, Which Needs Neither a Display nor a GPU
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr)
+        mDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, nullptr, nullptr))
+    {
+        fprintf(stderr, "Failed to Initialize EGL\n");
+        return;
+    }
+
+    // Create a Core Profile Context Without Any Surface
+    EGLint const attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 0,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    eglBindAPI(EGL_OPENGL_API);
+    mContext = eglCreateContext(mDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (mContext == EGL_NO_CONTEXT || !eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, mContext))
+    {
+        fprintf(stderr, "Failed to Create OpenGL Context (EGL error 0x%x)\n", eglGetError());
+        return;
+    }
+    gladLoadGLLoader((GLADloadproc) eglGetProcAddress);
+
+    // Render Into a Framebuffer Object Sized Like the Window Would Be
+    glGenRenderbuffers(1, & mColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, & mDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glGenFramebuffers(1, & mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Offscreen Framebuffer is Incomplete\n");
+        return;
+    }
+    glViewport(0, 0, width, height);
+    mValid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (mContext != EGL_NO_CONTEXT)
+    {
+        glDeleteFramebuffers(1, & mFramebuffer);
+        glDeleteRenderbuffers(1, & mColorBuffer);
+        glDeleteRenderbuffers(1, & mDepthBuffer);
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(mDisplay, mContext);
+    }
+    if (mDisplay != EGL_NO_DISPLAY)
+        eglTerminate(mDisplay);
+}
+
+#else
+
+HeadlessContext::HeadlessContext(int, int)
+        : mDisplay(nullptr)
+        , mContext(nullptr)
+        , mFramebuffer(0)
+        , mColorBuffer(0)
+        , mDepthBuffer(0)
+        , mValid(false)
+{
+    fprintf(stderr, "Headless Mode Requires a Linux Build With EGL\n");
+}
+
+HeadlessContext::~HeadlessContext() {}
+
+#endif
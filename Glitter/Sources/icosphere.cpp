@@ -0,0 +1,171 @@
+// Local Headers
+#include "icosphere.hpp"
+
+// System Headers
+#include <glm/gtc/constants.hpp>
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+// Edge length on screen, in pixels, that each level is chosen to stay under
+static const float edgePixels = 6.0f;
+
+// How far past a threshold, as a factor of the radius, a sphere must grow or
+// shrink before it changes level
+static const float hysteresis = 1.25f;
+
+// Edge of an icosahedron over the radius of its circumscribed sphere
+static const float edgeRatio = 1.0515f;
+
+Icosphere::Icosphere(float radius)
+{
+    // Each level's indices are offset past the vertices of the levels before
+    std::vector<Mirage::Vertex> vertices, level;
+    std::vector<unsigned int> indices, levelIndices;
+    for (int i = 0; i < Levels; i++)
+    {
+        build(i, radius, level, levelIndices);
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        mFirstIndex[i] = static_cast<GLuint>(indices.size());
+        vertices.insert(vertices.end(), level.begin(), level.end());
+        for (auto index : levelIndices)
+            indices.push_back(base + index);
+    }
+    mMesh.reset(new Mirage::Mesh(vertices.data(), vertices.size(), indices.data(), indices.size(),
+                                 std::vector<Mirage::Texture>(), Mirage::VertexFormat::Compact));
+}
+
+void Icosphere::build(int subdivisions, float radius,
+                      std::vector<Mirage::Vertex> & vertices, std::vector<unsigned int> & indices)
+{
+    // The twelve corners of an icosahedron and its faces, wound counterclockwise from outside
+    const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+    std::vector<glm::vec3> points = {
+        {-1.0f,  t, 0.0f}, { 1.0f,  t, 0.0f}, {-1.0f, -t, 0.0f}, { 1.0f, -t, 0.0f},
+        {0.0f, -1.0f,  t}, {0.0f,  1.0f,  t}, {0.0f, -1.0f, -t}, {0.0f,  1.0f, -t},
+        { t, 0.0f, -1.0f}, { t, 0.0f,  1.0f}, {-t, 0.0f, -1.0f}, {-t, 0.0f,  1.0f},
+    };
+    std::vector<unsigned int> faces = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1,
+    };
+    for (auto & point : points)
+        point = glm::normalize(point);
+
+    // Split every face in four; an edge's midpoint is shared by both faces along it
+    for (int level = 0; level < subdivisions; level++)
+    {
+        std::unordered_map<std::uint64_t, unsigned int> midpoints;
+        auto midpoint = [&points, &midpoints](unsigned int a, unsigned int b) {
+            std::uint64_t key = (std::uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+                return found->second;
+            unsigned int index = static_cast<unsigned int>(points.size());
+            points.push_back(glm::normalize(points[a] + points[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<unsigned int> split;
+        split.reserve(faces.size() * 4);
+        for (std::size_t i = 0; i < faces.size(); i += 3)
+        {
+            unsigned int a = faces[i], b = faces[i + 1], c = faces[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            unsigned int corners[] = { a, ab, ca,   b, bc, ab,   c, ca, bc,   ab, bc, ca };
+            split.insert(split.end(), corners, corners + 12);
+        }
+        faces.swap(split);
+    }
+
+    // Longitude runs along u and colatitude along v; +Z is a quarter turn west of +X
+    vertices.clear();
+    for (auto const & point : points)
+    {
+        Mirage::Vertex vertex = Mirage::Vertex();
+        vertex.Position = point * radius;
+        vertex.Normal = point;
+        vertex.TexCoords = glm::vec2(0.5f + std::atan2(-point.z, point.x) / glm::two_pi<float>(),
+                                     std::acos(glm::clamp(point.y, -1.0f, 1.0f)) / glm::pi<float>());
+        vertices.push_back(vertex);
+    }
+
+    // Faces across the date line need copies of their western corners one turn
+    // further on, and every face at a pole its own copy of the pole, at the
+    // longitude of the face
+    std::unordered_map<unsigned int, unsigned int> wrapped;
+    indices.clear();
+    indices.reserve(faces.size());
+    for (std::size_t i = 0; i < faces.size(); i += 3)
+    {
+        unsigned int corner[3] = { faces[i], faces[i + 1], faces[i + 2] };
+        bool pole[3];
+        float lower = 1.0f, upper = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            glm::vec3 const & point = points[corner[k]];
+            pole[k] = std::fabs(point.x) < 1e-6f && std::fabs(point.z) < 1e-6f;
+            if (pole[k]) continue;
+            lower = std::min(lower, vertices[corner[k]].TexCoords.x);
+            upper = std::max(upper, vertices[corner[k]].TexCoords.x);
+        }
+
+        if (upper - lower > 0.5f)
+            for (int k = 0; k < 3; k++)
+            {
+                if (pole[k] || vertices[corner[k]].TexCoords.x >= 0.5f)
+                    continue;
+                auto found = wrapped.find(corner[k]);
+                if (found == wrapped.end())
+                {
+                    Mirage::Vertex vertex = vertices[corner[k]];
+                    vertex.TexCoords.x += 1.0f;
+                    found = wrapped.emplace(corner[k], static_cast<unsigned int>(vertices.size())).first;
+                    vertices.push_back(vertex);
+                }
+                corner[k] = found->second;
+            }
+
+        for (int k = 0; k < 3; k++)
+        {
+            if (!pole[k]) continue;
+            float u = 0.0f;
+            for (int other = 0; other < 3; other++)
+                if (other != k) u += vertices[corner[other]].TexCoords.x * 0.5f;
+            Mirage::Vertex vertex = vertices[corner[k]];
+            vertex.TexCoords.x = u;
+            corner[k] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(vertex);
+        }
+        indices.insert(indices.end(), corner, corner + 3);
+    }
+}
+
+// Coarsest level whose edges stay under the target length on screen
+static int idealLevel(float pixelRadius)
+{
+    float edge = pixelRadius * edgeRatio / edgePixels;
+    int level = 0;
+    while (edge > 1.0f && level < Icosphere::Levels - 1)
+    {
+        edge *= 0.5f;
+        level++;
+    }
+    return level;
+}
+
+int Icosphere::select(float pixelRadius, int current)
+{
+    int finer = idealLevel(pixelRadius / hysteresis);
+    int coarser = idealLevel(pixelRadius * hysteresis);
+    if (finer > current) return finer;
+    if (coarser < current) return coarser;
+    return current;
+}
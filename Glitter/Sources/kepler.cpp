@@ -0,0 +1,113 @@
+// Local Headers
+#include "kepler.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+static const double degreesToRadians = pi / 180.0;
+static const double daysPerCentury = 36525.0;
+
+// Newton iterations stop once every anomaly moved less than this, in radians.
+static const double tolerance = 1e-14;
+static const int    maxIterations = 16;
+
+// Rotates a point from the orbital plane (x towards the periapsis) into the
+// ecliptic frame, given the argument of periapsis, the node and inclination.
+static inline glm::dvec3 toEcliptic(double xp, double yp, double w, double node, double i)
+{
+    double cw = std::cos(w),    sw = std::sin(w);
+    double cn = std::cos(node), sn = std::sin(node);
+    double ci = std::cos(i),    si = std::sin(i);
+    return glm::dvec3((cw * cn - sw * sn * ci) * xp + (-sw * cn - cw * sn * ci) * yp,
+                      (cw * sn + sw * cn * ci) * xp + (-sw * sn + cw * cn * ci) * yp,
+                      (sw * si) * xp + (cw * si) * yp);
+}
+
+int KeplerPropagator::add(OrbitalElements const & elements)
+{
+    mSemiMajorAxis.push_back(elements.semiMajorAxis);
+    mEccentricity.push_back(elements.eccentricity);
+    mInclination.push_back(elements.inclination * degreesToRadians);
+    mMeanLongitude.push_back(elements.meanLongitude * degreesToRadians);
+    mPerihelionLongitude.push_back(elements.perihelionLongitude * degreesToRadians);
+    mAscendingNode.push_back(elements.ascendingNode * degreesToRadians);
+
+    mSemiMajorAxisRate.push_back(elements.semiMajorAxisRate);
+    mEccentricityRate.push_back(elements.eccentricityRate);
+    mInclinationRate.push_back(elements.inclinationRate * degreesToRadians);
+    mMeanLongitudeRate.push_back(elements.meanLongitudeRate * degreesToRadians);
+    mPerihelionLongitudeRate.push_back(elements.perihelionLongitudeRate * degreesToRadians);
+    mAscendingNodeRate.push_back(elements.ascendingNodeRate * degreesToRadians);
+
+    std::size_t count = size();
+    for (auto scratch : { &mA, &mE, &mI, &mM, &mArgument, &mNode, &mAnomaly })
+        scratch->resize(count);
+    return static_cast<int>(count) - 1;
+}
+
+void KeplerPropagator::propagate(double julianDate, double * x, double * y, double * z)
+{
+    std::size_t count = size();
+    double T = (julianDate - J2000) / daysPerCentury;
+
+    // Elements at the requested date, with the mean anomaly wrapped to [-pi, pi]
+    for (std::size_t i = 0; i < count; i++)
+    {
+        double perihelion = mPerihelionLongitude[i] + mPerihelionLongitudeRate[i] * T;
+        double node       = mAscendingNode[i] + mAscendingNodeRate[i] * T;
+        double M          = mMeanLongitude[i] + mMeanLongitudeRate[i] * T - perihelion;
+        mA[i]        = mSemiMajorAxis[i] + mSemiMajorAxisRate[i] * T;
+        mE[i]        = std::min(std::max(mEccentricity[i] + mEccentricityRate[i] * T, 0.0), 0.99);
+        mI[i]        = mInclination[i] + mInclinationRate[i] * T;
+        mM[i]        = M - 2.0 * pi * std::floor((M + pi) / (2.0 * pi));
+        mArgument[i] = perihelion - node;
+        mNode[i]     = node;
+        mAnomaly[i]  = mE[i] < 0.8 ? mM[i] + mE[i] * std::sin(mM[i]) : pi;
+    }
+
+    // Solve Kepler's equation, M = E - e sin E, for all bodies at once
+    for (int iteration = 0; iteration < maxIterations; iteration++)
+    {
+        double largest = 0.0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            double E = mAnomaly[i];
+            double delta = (E - mE[i] * std::sin(E) - mM[i]) / (1.0 - mE[i] * std::cos(E));
+            mAnomaly[i] = E - delta;
+            largest = std::max(largest, std::abs(delta));
+        }
+        if (largest < tolerance) break;
+    }
+
+    // Position in the orbital plane, rotated into the ecliptic
+    for (std::size_t i = 0; i < count; i++)
+    {
+        double E  = mAnomaly[i];
+        double xp = mA[i] * (std::cos(E) - mE[i]);
+        double yp = mA[i] * std::sqrt(1.0 - mE[i] * mE[i]) * std::sin(E);
+        glm::dvec3 position = toEcliptic(xp, yp, mArgument[i], mNode[i], mI[i]);
+        x[i] = position.x;
+        y[i] = position.y;
+        z[i] = position.z;
+    }
+}
+
+void KeplerPropagator::sample(std::size_t body, double julianDate, int count, std::vector<glm::dvec3> & points) const
+{
+    double T = (julianDate - J2000) / daysPerCentury;
+    double a = mSemiMajorAxis[body] + mSemiMajorAxisRate[body] * T;
+    double e = std::min(std::max(mEccentricity[body] + mEccentricityRate[body] * T, 0.0), 0.99);
+    double i = mInclination[body] + mInclinationRate[body] * T;
+    double node = mAscendingNode[body] + mAscendingNodeRate[body] * T;
+    double w = mPerihelionLongitude[body] + mPerihelionLongitudeRate[body] * T - node;
+    double b = a * std::sqrt(1.0 - e * e);
+
+    points.clear();
+    for (int k = 0; k < count; k++)
+    {
+        double E = 2.0 * pi * k / count;
+        points.push_back(toEcliptic(a * (std::cos(E) - e), b * std::sin(E), w, node, i));
+    }
+}
@@ -9,19 +9,19 @@
 #include <cstdio>
 #include <cstdlib>
 
-// Shader header
-#include <shader.hpp>
+// Scene, Benchmark and Offscreen Context
+#include "benchmark.hpp"
+#include "headless.hpp"
+#include "solar_system.hpp"
 
 //Camera header
 #include <Camera.h>
 
-//Model
-#include <Model.h>
-
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
 #include <vector>
-#include <iostream>
-
-#define STB_IMAGE_IMPLEMENTATION
 
 //Camera setting
 const std::string program_name = ("Camera");
@@ -29,19 +29,145 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
-unsigned int loadCubemap(std::vector<std::string> faces);
 
 static Camera camera(glm::vec3(400.0f, 0.0f, -100.0f));
 static float lastX = 1200 / 2.0f;
 static float lastY = 800 / 2.0f;
 static bool firstMouse = true;
 
+// simulation ticks per second in a window, unless given with --tick-rate
+static const double defaultTickRate = 120.0;
+
 // timing
 static float deltaTime = 0.0f; // time between current frame and last frame
 static float lastFrame = 0.0f;
 
 int main(int argc, char * argv[]) {
 
+    // Parse Command Line Options
+    bool headless = false;
+    int frames = 1000;
+    double epoch = J2000;
+    double warp = -1.0;
+    std::string sceneFile = SceneFile::DefaultPath;
+    int asteroids = -1;
+    double tickRate = -1.0;
+    bool gravity = false;
+    int particles = -1;
+    int ring = -1;
+    std::string ephemeris;
+    std::string writeEphemeris;
+    double from = 2378496.5; // 1800 January 1, where the planets' elements start to hold
+    double to = 2469807.5;   // 2050 January 1, where they stop
+    std::string trace;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--epoch" && i + 1 < argc)
+            epoch = std::atof(argv[++i]);
+        else if (arg == "--warp" && i + 1 < argc)
+            warp = std::atof(argv[++i]);
+        else if (arg == "--scene" && i + 1 < argc)
+            sceneFile = argv[++i];
+        else if (arg == "--belt" && i + 1 < argc)
+            asteroids = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--max-texture" && i + 1 < argc)
+            Mirage::MipChain::setMaxResolution(std::atoi(argv[++i]));
+        else if (arg == "--virtual-texture" && i + 1 < argc)
+            Mirage::TileFile::setMinResolution(std::atoi(argv[++i]));
+        else if (arg == "--texture-budget" && i + 1 < argc)
+            Mirage::TextureCache::global().setBudget(std::size_t(std::max(0, std::atoi(argv[++i]))) << 20);
+        else if (arg == "--tick-rate" && i + 1 < argc)
+            tickRate = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--nbody")
+            gravity = true;
+        else if (arg == "--particles" && i + 1 < argc) {
+            gravity = true;
+            particles = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--ring" && i + 1 < argc) {
+            gravity = true;
+            ring = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--ephemeris" && i + 1 < argc)
+            ephemeris = argv[++i];
+        else if (arg == "--write-ephemeris" && i + 1 < argc)
+            writeEphemeris = argv[++i];
+        else if (arg == "--from" && i + 1 < argc)
+            from = std::atof(argv[++i]);
+        else if (arg == "--to" && i + 1 < argc)
+            to = std::atof(argv[++i]);
+        else if (arg == "--profile" && i + 1 < argc)
+            trace = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--headless] [--frames N] [--epoch JD] [--warp days/s] [--scene file] [--belt N] [--max-texture pixels] [--virtual-texture pixels] [--texture-budget MiB] [--tick-rate Hz] [--nbody] [--particles N] [--ring N] [--ephemeris file] [--write-ephemeris file [--from JD] [--to JD]] [--profile trace.json]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Read the Scene, With the Rock and Particle Counts Given Here in Place
+    // of Its Own; the Particles Go to Its Population "belt", the Ring to Its
+    // Population "rings"
+    SceneFile description;
+    if (!description.load(sceneFile))
+        return EXIT_FAILURE;
+    SceneFile::Belt & belt = description.belt;
+    if (asteroids >= 0) belt.rocks = asteroids;
+    auto populate = [&](char const * name, int count) {
+        int index = description.findPopulation(name);
+        if (index < 0)
+            fprintf(stderr, "Scene %s has no population %s; ignoring its particles\n", sceneFile.c_str(), name);
+        else
+            description.populations[index].particles = count;
+    };
+    if (particles >= 0) populate("belt", particles);
+    if (ring >= 0) populate("rings", ring);
+    if (belt.rocks > 0 && (belt.outer <= belt.inner || belt.period <= 0.0)) {
+        fprintf(stderr, "Scene %s has no belt to put rocks in\n", sceneFile.c_str());
+        belt.rocks = 0;
+    }
+
+    // Fit the Orbits Into an Ephemeris File and Stop
+    if (!writeEphemeris.empty()) {
+        double error = 0.0;
+        if (!SolarSystem::writeEphemeris(description, writeEphemeris, from, to, &error)) {
+            fprintf(stderr, "Failed to Write Ephemeris %s\n", writeEphemeris.c_str());
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "Ephemeris: JD %.1f to %.1f, within %.3f km of the orbits\n", from, to, error);
+        return EXIT_SUCCESS;
+    }
+
+    // Record Every Pass, Exported as a Chrome Trace on P and at Exit
+    Mirage::Profiler & profiler = Mirage::Profiler::global();
+    profiler.enable(!trace.empty());
+
+    // Render Offscreen on a Software Context and Report Frame Timings
+    if (headless) {
+        HeadlessContext context(mWidth, mHeight);
+        if (!context.valid())
+            return EXIT_FAILURE;
+        fprintf(stderr, "OpenGL %s\n", glGetString(GL_VERSION));
+        glEnable(GL_DEPTH_TEST);
+
+        SolarSystem scene(description);
+        scene.seek(epoch);
+        if (warp >= 0.0) scene.setTimeWarp(warp);
+        if (gravity) scene.useGravity();
+        if (!ephemeris.empty() && !scene.useEphemeris(ephemeris))
+            fprintf(stderr, "Ephemeris %s is missing or stale; propagating the elements\n", ephemeris.c_str());
+
+        // The benchmark steps the simulation once per frame unless asked for a thread
+        if (tickRate > 0.0) scene.startSimulation(tickRate);
+        runBenchmark(scene, camera, frames);
+        if (profiler.enabled() && !profiler.exportTrace(trace))
+            fprintf(stderr, "Failed to Write Trace %s\n", trace.c_str());
+        return EXIT_SUCCESS;
+    }
+
     // Load GLFW and Create a Window
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -73,401 +199,60 @@ int main(int argc, char * argv[]) {
 //    stbi_set_flip_vertically_on_load(true);
     glEnable(GL_DEPTH_TEST);
 
-    Mirage::Shader shaderProgram;
-    shaderProgram.attach("shader.vert");
-    shaderProgram.attach("shader.frag");
-    shaderProgram.link().activate();
-
-
-    Mirage::Shader SkyboxShader;
-    SkyboxShader.attach("skybox.vert");
-    SkyboxShader.attach("skybox.frag");
-    SkyboxShader.link().activate();
-
-    Mirage::Shader lightSource;
-    lightSource.attach("shader.vert");
-    lightSource.attach("light_source.frag");
-    lightSource.link().activate();
-
-    Mirage::Shader planetTracks;
-    planetTracks.attach("tracks.vert");
-    planetTracks.attach("tracks.frag");
-    planetTracks.link().activate();
-
-    Model Sun ( "Models/sun/sun.obj");
-    Model Mercury ( "Models/Mercury/mercury.obj");
-    Model venus( "Models/Venus/venus.obj");
-    Model Earth( "Models/Earth/earth.obj");
-    Model Mars ( "Models/Mars/mars.obj");
-    Model Jupiter ( "Models/Jupiter/jupiter.obj");
-    Model Saturn ( "Models/Saturn/scene.gltf");
-    Model Uranus ( "Models/Uranus/uranus.obj");
-    Model Neptune ( "Models/Neptune/neptune.obj");
-    Model Moon ( "Models/Moon/moon.obj");
-
-    float skyboxVertices[] = {
-            // positions
-            -1.0f,  1.0f, -1.0f,
-            -1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            -1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f
-    };
+    {
+        SolarSystem scene(description);
+        scene.seek(epoch);
+        if (warp >= 0.0) scene.setTimeWarp(warp);
+        if (gravity) scene.useGravity();
+        if (!ephemeris.empty() && !scene.useEphemeris(ephemeris))
+            fprintf(stderr, "Ephemeris %s is missing or stale; propagating the elements\n", ephemeris.c_str());
+
+        // Simulate on a thread of its own unless the rate is zero
+        if (tickRate < 0.0) tickRate = defaultTickRate;
+        if (tickRate > 0.0) scene.startSimulation(tickRate);
+
+        // Rendering Loop
+        bool exportHeld = false;
+        while (glfwWindowShouldClose(mWindow) == false) {
+            // per-frame time logic
+            // --------------------
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+
+            processInput(mWindow);
+
+            // Export the trace once per press
+            bool exportPressed = glfwGetKey(mWindow, GLFW_KEY_P) == GLFW_PRESS;
+            if (exportPressed && !exportHeld && profiler.enabled()) {
+                if (profiler.exportTrace(trace)) fprintf(stderr, "Wrote Trace %s\n", trace.c_str());
+                else fprintf(stderr, "Failed to Write Trace %s\n", trace.c_str());
+            }
+            exportHeld = exportPressed;
+
+            if (scene.simulating()) scene.interpolate();
+            else scene.update(currentFrame);
+            scene.draw(camera);
 
-    /* SKYBOX GENERATION */
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    /* SKYBOX GENERATION */
-
-    std::vector<std::string> faces
             {
-                     "Skybox/starfield_bk.tga",
-                     "Skybox/starfield_dn.tga",
-                     "Skybox/starfield_ft.tga",
-                     "Skybox/starfield_lf.tga",
-                     "Skybox/starfield_rt.tga",
-                     "Skybox/starfield_up.tga"
-            };
-
-    unsigned int cubemapTexture = loadCubemap(faces);
-
-    float rotationSpeedScale = 1.0f;
-
-    long distanceSunToMercury = 57910000L; // Mercury's distance from the Sun in kilometers
-    long distanceSunToVenus = 108200000L;  // Venus's distance from the Sun in kilometers
-    long distanceSunToEarth = 149600000L;  // Earth's distance from the Sun in kilometers
-    long distanceSunToMoon = 149984400L;   // Moon's distance from the Sun in Kilometers
-    long distanceSunToMars = 227940000L;   // Mars's distance from the Sun in kilometers
-    long distanceSunToJupiter = 778330000L;// Jupiter's distance from the Sun in kilometers
-    long distanceSunToSaturn = 1429400000L; // Saturn's distance from the Sun in kilometers
-    long long distanceSunToUranus = 2870990000L; // Uranus's distance from the Sun in kilometers
-    long long distanceSunToNeptune = 4497100000L;// Neptune's distance from the Sun in kilometers
-
-    float scalingCoef = 0.0000005f;
-    float addedValue = 150.0f;
-
-    float mercuryAngle = 0.0f;
-    float mercuryIncrementAngle = 360.0f/88.0f;
-
-    float venusAngle = 0.0f;
-    float venusIncrementAngle = 360.0f/225.0f;
-
-    float earthAngle = 0.0f;
-    float earthIncrementAngle = 360.0f/365.0f;
-
-    float marsAngle = 0.0f;
-    float marsIncrementAngle = 360.0f/687.0f;
-
-    float jupiterAngle = 0.0f;
-    float jupiterIncrementAngle = 360.0f/4333.0f;
-
-    float saturnAngle = 0.0f;
-    float saturnIncrementAngle = 360.0f/10759.0f;
-
-    float uranusAngle = 0.0f;
-    float uranusIncrementAngle = 360.0f/30688.0f;
-
-    float neptuneAngle = 0.0f;
-    float neptuneIncrementAngle = 360.0f/60190.0f;
-
-    float speedCoefficient  = 0.001f;
-
-
-    //moon rotating around the earth
-    long distanceEarthToMoon = 384400L; // Moon's distance from Earth in kilometers
-
-    float moonAngle = 0.0f;
-    float moonIncrementAngle = 360.0f/27.3f;
-
-
-    //==================================================== planets tracks =================
-    float distances[9];
-    distances[0] = ((float)distanceSunToMercury * scalingCoef) + addedValue;
-    distances[1] = ((float)distanceSunToVenus * scalingCoef) + addedValue;
-    distances[2] = ((float)distanceSunToEarth * scalingCoef) + addedValue;
-    distances[3] = ((float)distanceSunToMars * scalingCoef) + addedValue;
-    distances[4] = ((float)distanceSunToJupiter * scalingCoef) + addedValue;
-    distances[5] = ((float)distanceSunToSaturn * scalingCoef) + addedValue;
-    distances[6] = ((float)distanceSunToUranus * scalingCoef) + addedValue;
-    distances[7] = ((float)distanceSunToNeptune * scalingCoef) + addedValue;
-    std::cout<<distances[0]<<std::endl;
-    std::vector<float> vertices;
-    float x, y = 0.0f, z;
-    int numAngles = 180;
-    float angle = 0.0f;
-    float increment = 2 * 3.1415926 / numAngles;
-    for(int j=0; j<8; j++) {
-        for (int i = 0; i < numAngles; i++) {
-            x = distances[j] * cos(angle);
-            z = distances[j] * sin(angle);
-
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            angle += increment;
-        }
-        angle = 0.0f;
-    }
+                Mirage::Profiler::Scope scope("sleep");
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
 
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void *>(nullptr));
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glLineWidth(20);
-
-    // Rendering Loop
-    while (glfwWindowShouldClose(mWindow) == false) {
-        // per-frame time logic
-        // --------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        processInput(mWindow);
-
-        glm::mat4 view;
-        glm::mat4 model;
-
-        // Background Fill Color
-        glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // activate shader
-        shaderProgram.activate();
-
-        // Set the light source position (Sun position)
-        glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 0.0f); // Replace with actual Sun position
-        glUniform3fv(glGetUniformLocation(shaderProgram.get(), "lightPos"), 1, &lightPos[0]);
-
-        // Set the camera (viewer) position
-        glm::vec3 viewPos = camera.Position; // Replace with actual camera position
-        glUniform3fv(glGetUniformLocation(shaderProgram.get(), "viewPos"), 1, &viewPos[0]);
-
-
-
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                                                (float)1200 / (float)800, 0.1f, 8000.0f);
-        view = camera.GetViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "projection"), 1, GL_FALSE,
-                           &projection[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "view"), 1, GL_FALSE,
-                           &view[0][0]);
-
-        // Calculate rotation angles for each planet based on time (currentFrame)
-        float mercuryRotationAngle = glm::radians(currentFrame * 3.0083f * rotationSpeedScale);
-        float venusRotationAngle = glm::radians(currentFrame * 1.8111f * rotationSpeedScale);
-        float earthRotationAngle = glm::radians(currentFrame * 447.04f * rotationSpeedScale);
-        float marsRotationAngle = glm::radians(currentFrame * 240.56f * rotationSpeedScale);
-        float jupiterRotationAngle = glm::radians(currentFrame * 241.67f * rotationSpeedScale);
-        float saturnRotationAngle = glm::radians(currentFrame * 284.72f * rotationSpeedScale);
-        float uranusRotationAngle = glm::radians(currentFrame * 196.39f * rotationSpeedScale);
-        float neptuneRotationAngle = glm::radians(currentFrame * 242.78f * rotationSpeedScale);
-        float moonRotationAngle = glm::radians(currentFrame * 0.2292f * rotationSpeedScale);
-
-
-        //Mercury
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToMercury * scalingCoef) + addedValue) * cos(mercuryAngle), 0.0f, -(((float)distanceSunToMercury * scalingCoef) + addedValue) * sin(mercuryAngle)));
-        model = glm::rotate(model, mercuryRotationAngle, glm::vec3(0.0f, 0.1f, 1.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Mercury.Draw(shaderProgram);
-        mercuryAngle += mercuryIncrementAngle * speedCoefficient;
-
-        // Venus
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToVenus * scalingCoef) + addedValue) * cos(venusAngle), 0.0f, -(((float)distanceSunToVenus * scalingCoef) + addedValue) * sin(venusAngle)));
-        model = glm::rotate(model, venusRotationAngle, glm::vec3(0.0f, -0.1f, 1.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        venus.Draw(shaderProgram);
-        venusAngle += venusIncrementAngle * speedCoefficient;
-
-        // Earth
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3((((float)distanceSunToEarth * scalingCoef) + addedValue) * cos(earthAngle), 0.0f, -(((float)distanceSunToEarth * scalingCoef) + addedValue) * sin(earthAngle)));
-        model = glm::rotate(model, glm::radians(-20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::rotate(model, earthRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE,&model[0][0]);
-        Earth.Draw(shaderProgram);
-        earthAngle+=earthIncrementAngle * speedCoefficient;
-
-        // Moon
-        model = glm::mat4(1.0f);
-        model = glm::translate(model,
-                               glm::vec3(((((float)distanceSunToEarth * scalingCoef) + addedValue) * cos(earthAngle))
-                                         + ((((float)distanceEarthToMoon * scalingCoef) + 5.0f) * cos(moonAngle)),
-                                         0.0f,
-                                         (-((((float)distanceSunToEarth * scalingCoef) + addedValue) * sin(earthAngle)))
-                                         - ((((float)distanceEarthToMoon * scalingCoef) + 5.0f) * sin(moonAngle))));
-        model = glm::rotate(model, glm::radians(-20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::rotate(model, moonRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE,&model[0][0]);
-        Moon.Draw(shaderProgram);
-        moonAngle += moonIncrementAngle * speedCoefficient;
-
-        //Mars
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToMars * scalingCoef) + addedValue) * cos(marsAngle), 0.0f, -(((float)distanceSunToMars * scalingCoef) + addedValue) * sin(marsAngle)));
-        model = glm::rotate(model, glm::radians(-20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::rotate(model, marsRotationAngle, glm::vec3(0.0f, 1.0f, 0.05f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Mars.Draw(shaderProgram);
-        marsAngle+=marsIncrementAngle * speedCoefficient;
-
-        //Jupiter
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToJupiter * scalingCoef) + addedValue) * cos(jupiterAngle), 0.0f, -(((float)distanceSunToJupiter * scalingCoef) + addedValue) * sin(jupiterAngle)));
-        model = glm::rotate(model, jupiterRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Jupiter.Draw(shaderProgram);
-        jupiterAngle += jupiterIncrementAngle * speedCoefficient;
-
-        //Saturn
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToSaturn * scalingCoef) + addedValue) * cos(saturnAngle), 0.0f, -(((float)distanceSunToSaturn * scalingCoef) + addedValue) * sin(saturnAngle)));
-        model = glm::rotate(model, glm::radians(35.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, saturnRotationAngle, glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::scale(model, glm::vec3(1.2f, 1.2f, 1.2f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Saturn.Draw(shaderProgram);
-        saturnAngle += saturnIncrementAngle * speedCoefficient;
-
-        //Uranus
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToUranus * scalingCoef) + addedValue) * cos(uranusAngle), 0.0f, -(((float)distanceSunToUranus * scalingCoef) + addedValue) * sin(uranusAngle)));
-        model = glm::rotate(model, uranusRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Uranus.Draw(shaderProgram);
-        uranusAngle += uranusIncrementAngle * speedCoefficient;
-
-        //Neptune
-        model = glm::mat4(1.0f); // Reset the model matrix for Venus
-        model = glm::translate(model, glm::vec3((((float)distanceSunToNeptune * scalingCoef) + addedValue) * cos(neptuneAngle), 0.0f, -(((float)distanceSunToNeptune * scalingCoef) + addedValue) * sin(neptuneAngle)));
-        model = glm::rotate(model, glm::radians(20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::rotate(model, neptuneRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));       // scale as needed
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        Neptune.Draw(shaderProgram);
-        neptuneAngle += neptuneIncrementAngle * speedCoefficient;
-
-        lightSource.activate();
-        // Position the Sun
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model = glm::rotate(model, (GLfloat)glfwGetTime() * glm::radians(23.5f) * 0.25f, glm::vec3(0.0f, 0.0f, 1.f));
-        glUniformMatrix4fv(glGetUniformLocation(lightSource.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(lightSource.get(), "projection"), 1, GL_FALSE,
-                           &projection[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(lightSource.get(), "view"), 1, GL_FALSE,
-                           &view[0][0]);
-        Sun.Draw(lightSource);
-
-        Sleep(10);
-
-        /* DRAW SKYBOX */
-        glDepthFunc(GL_LEQUAL);
-        SkyboxShader.activate();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-        glUniformMatrix4fv(glGetUniformLocation(SkyboxShader.get(), "view"), 1, GL_FALSE,
-                           &view[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(SkyboxShader.get(), "projection"), 1, GL_FALSE,
-                           &projection[0][0]);
-        // skybox cube
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
-        /* DRAW SKYBOX */
-
-        planetTracks.activate();
-
-        model = glm::mat4(1.0f);
-        view = camera.GetViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(planetTracks.get(), "model"), 1, GL_FALSE, &model[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(planetTracks.get(), "projection"), 1, GL_FALSE,
-                           &projection[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(planetTracks.get(), "view"), 1, GL_FALSE,
-                           &view[0][0]);
-
-        int vertexColorLocation = glGetUniformLocation(planetTracks.get(), "uColor");
-        glUniform4f(vertexColorLocation, 1.0f, 1.0f, 1.0f, 1.0f);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_LINE_LOOP, 0, numAngles);
-        glDrawArrays(GL_LINE_LOOP, numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 2 * numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 3 * numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 4 * numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 5 * numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 6 * numAngles, numAngles);
-        glDrawArrays(GL_LINE_LOOP, 7 * numAngles, numAngles);
-
-        // Flip Buffers and Draw
-        glfwSwapBuffers(mWindow);
-        glfwPollEvents();
+            // Flip Buffers and Draw
+            {
+                Mirage::Profiler::Scope scope("swap");
+                glfwSwapBuffers(mWindow);
+            }
+            {
+                Mirage::Profiler::Scope scope("events");
+                glfwPollEvents();
+            }
+            profiler.frame();
+        }
     }
+    if (profiler.enabled() && !profiler.exportTrace(trace))
+        fprintf(stderr, "Failed to Write Trace %s\n", trace.c_str());
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
@@ -528,38 +313,3 @@ void mouse_callback(GLFWwindow *window, double xposd, double yposd) {
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
-
-unsigned int loadCubemap(std::vector<std::string> faces)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-
-    for (unsigned int i = 0; i < faces.size(); i++)
-    {
-
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                         0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
-            );
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
-}
\ No newline at end of file
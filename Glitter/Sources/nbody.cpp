@@ -0,0 +1,532 @@
+// Local Headers
+#include "nbody.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// Particles per leaf: the leaf is also the group that walks the tree
+// together, so a larger one shares more of the walk but sums more pairs.
+static const std::uint32_t leafSize = 16;
+
+// Morton keys hold 21 bits per axis, which bounds the depth of the tree.
+static const int keyBits = 21;
+
+// Chunks of work handed to each thread at a time.
+static const std::size_t particleGrain = 4096;
+static const std::size_t leafGrain = 32;
+
+// Spreads the low 21 bits of a coordinate three bits apart.
+static inline std::uint64_t spread(std::uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8)  & 0x100f00f00f00f00full;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2)  & 0x1249249249249249ull;
+    return v;
+}
+
+// Octant of a key among the children of a cell at the given level, with the
+// x, y and z halves as its bits 2, 1 and 0.
+static inline unsigned int octant(std::uint64_t key, int level)
+{
+    return static_cast<unsigned int>(key >> (3 * (keyBits - 1 - level))) & 7;
+}
+
+static inline double milliseconds(std::chrono::steady_clock::time_point from,
+                                  std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+NBodyEngine::NBodyEngine(double theta, double softening, unsigned int threads)
+        : mTheta(theta)
+        , mSoftening(softening)
+        , mAccelerated(false)
+        , mCorner(0.0)
+        , mSize(1.0)
+        , mJob(nullptr)
+        , mJobCount(0)
+        , mJobGrain(1)
+        , mJobNext(0)
+        , mGeneration(0)
+        , mBusy(0)
+        , mStopping(false)
+        , mStats()
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < threads; i++)
+        mWorkers.emplace_back(&NBodyEngine::work, this);
+}
+
+NBodyEngine::~NBodyEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mJobReady.notify_all();
+    for (auto & worker : mWorkers)
+        worker.join();
+}
+
+std::size_t NBodyEngine::add(double mass, glm::dvec3 const & position, glm::dvec3 const & velocity)
+{
+    std::size_t id = mId.size();
+    mX.push_back(position.x);
+    mY.push_back(position.y);
+    mZ.push_back(position.z);
+    mVX.push_back(velocity.x);
+    mVY.push_back(velocity.y);
+    mVZ.push_back(velocity.z);
+    mAX.push_back(0.0);
+    mAY.push_back(0.0);
+    mAZ.push_back(0.0);
+    mMass.push_back(mass);
+    mId.push_back(static_cast<std::uint32_t>(id));
+    mSlot.push_back(static_cast<std::uint32_t>(id));
+    mAccelerated = false;
+    return id;
+}
+
+void NBodyEngine::reserve(std::size_t count)
+{
+    for (auto array : { &mX, &mY, &mZ, &mVX, &mVY, &mVZ, &mAX, &mAY, &mAZ, &mMass })
+        array->reserve(count);
+    mId.reserve(count);
+    mSlot.reserve(count);
+}
+
+void NBodyEngine::clear()
+{
+    for (auto array : { &mX, &mY, &mZ, &mVX, &mVY, &mVZ, &mAX, &mAY, &mAZ, &mMass })
+        array->clear();
+    mId.clear();
+    mSlot.clear();
+    mNodes.clear();
+    mLeaves.clear();
+    mAccelerated = false;
+}
+
+glm::dvec3 NBodyEngine::position(std::size_t id) const
+{
+    std::uint32_t i = mSlot[id];
+    return glm::dvec3(mX[i], mY[i], mZ[i]);
+}
+
+glm::dvec3 NBodyEngine::velocity(std::size_t id) const
+{
+    std::uint32_t i = mSlot[id];
+    return glm::dvec3(mVX[i], mVY[i], mVZ[i]);
+}
+
+void NBodyEngine::step(double dt)
+{
+    if (mId.empty())
+        return;
+    if (!mAccelerated)
+        accelerate();
+    kick(dt * 0.5);
+    drift(dt);
+    accelerate();
+    kick(dt * 0.5);
+}
+
+void NBodyEngine::kick(double dt)
+{
+    parallelFor(mId.size(), particleGrain, [this, dt](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            mVX[i] += mAX[i] * dt;
+            mVY[i] += mAY[i] * dt;
+            mVZ[i] += mAZ[i] * dt;
+        }
+    });
+}
+
+void NBodyEngine::drift(double dt)
+{
+    parallelFor(mId.size(), particleGrain, [this, dt](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            mX[i] += mVX[i] * dt;
+            mY[i] += mVY[i] * dt;
+            mZ[i] += mVZ[i] * dt;
+        }
+    });
+}
+
+void NBodyEngine::sort()
+{
+    std::size_t count = mId.size();
+
+    // Bounding cube of every particle, reduced per chunk
+    std::size_t chunks = (count + particleGrain - 1) / particleGrain;
+    std::vector<glm::dvec3> lower(chunks, glm::dvec3(std::numeric_limits<double>::max()));
+    std::vector<glm::dvec3> upper(chunks, glm::dvec3(-std::numeric_limits<double>::max()));
+    parallelFor(count, particleGrain, [&](std::size_t begin, std::size_t end) {
+        std::size_t chunk = begin / particleGrain;
+        for (std::size_t i = begin; i < end; i++)
+        {
+            glm::dvec3 p(mX[i], mY[i], mZ[i]);
+            lower[chunk] = glm::min(lower[chunk], p);
+            upper[chunk] = glm::max(upper[chunk], p);
+        }
+    });
+    glm::dvec3 low = lower[0], high = upper[0];
+    for (std::size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        low = glm::min(low, lower[chunk]);
+        high = glm::max(high, upper[chunk]);
+    }
+    glm::dvec3 extent = high - low;
+    mSize = std::max(std::max(extent.x, extent.y), extent.z) * (1.0 + 1e-9) + 1e-12;
+    mCorner = low;
+
+    // Quantize every position to the grid of the deepest level
+    const double cells = static_cast<double>(1 << keyBits);
+    const double scale = cells / mSize;
+    mKeys.resize(count);
+    parallelFor(count, particleGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            std::uint64_t x = static_cast<std::uint64_t>(std::min((mX[i] - low.x) * scale, cells - 1.0));
+            std::uint64_t y = static_cast<std::uint64_t>(std::min((mY[i] - low.y) * scale, cells - 1.0));
+            std::uint64_t z = static_cast<std::uint64_t>(std::min((mZ[i] - low.z) * scale, cells - 1.0));
+            Keyed keyed = { spread(x) << 2 | spread(y) << 1 | spread(z), static_cast<std::uint32_t>(i) };
+            mKeys[i] = keyed;
+        }
+    });
+
+    // Sort one run per thread, then merge runs pairwise, each round in parallel
+    auto less = [](Keyed const & a, Keyed const & b) { return a.key < b.key; };
+    std::size_t run = std::max<std::size_t>((count + threads() - 1) / threads(), 1);
+    std::size_t runs = (count + run - 1) / run;
+    parallelFor(runs, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t r = begin; r < end; r++)
+            std::sort(mKeys.begin() + r * run, mKeys.begin() + std::min((r + 1) * run, count), less);
+    });
+    mMerged.resize(count);
+    for (; run < count; run *= 2)
+    {
+        std::size_t pairs = (count + 2 * run - 1) / (2 * run);
+        parallelFor(pairs, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; p++)
+            {
+                std::size_t first = p * 2 * run;
+                std::size_t middle = std::min(first + run, count);
+                std::size_t last = std::min(first + 2 * run, count);
+                std::merge(mKeys.begin() + first, mKeys.begin() + middle,
+                           mKeys.begin() + middle, mKeys.begin() + last, mMerged.begin() + first, less);
+            }
+        });
+        mKeys.swap(mMerged);
+    }
+
+    // Move the state into key order; accelerations are recomputed after this
+    mScratch.resize(count);
+    for (auto array : { &mX, &mY, &mZ, &mVX, &mVY, &mVZ, &mMass })
+    {
+        parallelFor(count, particleGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+                mScratch[i] = (*array)[mKeys[i].index];
+        });
+        array->swap(mScratch);
+    }
+    mScratchId.resize(count);
+    parallelFor(count, particleGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            mScratchId[i] = mId[mKeys[i].index];
+    });
+    mId.swap(mScratchId);
+    parallelFor(count, particleGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            mSlot[mId[i]] = static_cast<std::uint32_t>(i);
+    });
+}
+
+void NBodyEngine::build()
+{
+    std::uint32_t count = static_cast<std::uint32_t>(mId.size());
+
+    // Split serially until cells are small enough to keep every thread busy,
+    // then build the subtrees below them in parallel
+    std::size_t grain = std::max<std::size_t>(leafSize, count / (threads() * 16));
+    std::vector<Subtree> deferred;
+    std::vector<Subtree> pending;
+    mNodes.assign(1, Node());
+    fill(mNodes, 0, 0, count, 0, mCorner + glm::dvec3(mSize * 0.5), grain, &deferred, &pending);
+
+    std::vector<std::vector<Node>> subtrees(deferred.size());
+    parallelFor(deferred.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t s = begin; s < end; s++)
+        {
+            Subtree const & subtree = deferred[s];
+            subtrees[s].assign(1, Node());
+            fill(subtrees[s], 0, subtree.begin, subtree.end, subtree.level, subtree.center, 0, nullptr, nullptr);
+        }
+    });
+
+    // Append each subtree below the top, its root taking the deferred node's
+    // place, so node k of a subtree lands at base + k - 1
+    for (std::size_t s = 0; s < deferred.size(); s++)
+    {
+        std::vector<Node> & nodes = subtrees[s];
+        std::uint32_t base = static_cast<std::uint32_t>(mNodes.size());
+        for (auto & node : nodes)
+            if (node.children > 0)
+                node.child += base - 1;
+        mNodes[deferred[s].node] = nodes[0];
+        mNodes.insert(mNodes.end(), nodes.begin() + 1, nodes.end());
+    }
+
+    // The top's moments, children before their parents
+    for (auto const & cell : pending)
+        moments(mNodes[cell.node], mNodes, cell.level, cell.center);
+
+    mLeaves.clear();
+    for (std::uint32_t i = 0; i < mNodes.size(); i++)
+        if (mNodes[i].children == 0)
+            mLeaves.push_back(i);
+}
+
+void NBodyEngine::fill(std::vector<Node> & nodes, std::uint32_t index, std::uint32_t begin, std::uint32_t end,
+                       int level, glm::dvec3 center, std::size_t grain, std::vector<Subtree> * deferred,
+                       std::vector<Subtree> * pending)
+{
+    nodes[index].begin = begin;
+    nodes[index].end = end;
+    nodes[index].child = 0;
+    nodes[index].children = 0;
+    if (end - begin <= leafSize || level == keyBits)
+    {
+        moments(nodes[index], nodes, level, center);
+        return;
+    }
+    if (deferred && end - begin <= grain)
+    {
+        Subtree subtree = { index, begin, end, level, center };
+        deferred->push_back(subtree);
+        return;
+    }
+
+    // The particles of each octant follow each other in key order
+    std::uint32_t bounds[9];
+    bounds[0] = begin;
+    for (unsigned int digit = 0; digit < 8; digit++)
+        bounds[digit + 1] = static_cast<std::uint32_t>(
+            std::partition_point(mKeys.begin() + bounds[digit], mKeys.begin() + end, [level, digit](Keyed const & keyed) {
+                return octant(keyed.key, level) <= digit;
+            }) - mKeys.begin());
+
+    std::uint32_t children = 0;
+    for (unsigned int digit = 0; digit < 8; digit++)
+        children += bounds[digit + 1] > bounds[digit];
+    std::uint32_t first = static_cast<std::uint32_t>(nodes.size());
+    nodes.resize(first + children);
+    nodes[index].child = first;
+    nodes[index].children = children;
+
+    double quarter = mSize / static_cast<double>(1 << level) * 0.25;
+    std::uint32_t child = first;
+    for (unsigned int digit = 0; digit < 8; digit++)
+    {
+        if (bounds[digit + 1] == bounds[digit])
+            continue;
+        glm::dvec3 offset(digit & 4 ? quarter : -quarter, digit & 2 ? quarter : -quarter, digit & 1 ? quarter : -quarter);
+        fill(nodes, child++, bounds[digit], bounds[digit + 1], level + 1, center + offset, grain, deferred, pending);
+    }
+
+    if (pending)
+    {
+        Subtree cell = { index, begin, end, level, center };
+        pending->push_back(cell);
+    }
+    else
+        moments(nodes[index], nodes, level, center);
+}
+
+void NBodyEngine::moments(Node & node, std::vector<Node> const & nodes, int level, glm::dvec3 const & center) const
+{
+    double mass = 0.0, x = 0.0, y = 0.0, z = 0.0;
+    if (node.children == 0)
+        for (std::uint32_t i = node.begin; i < node.end; i++)
+        {
+            mass += mMass[i];
+            x += mMass[i] * mX[i];
+            y += mMass[i] * mY[i];
+            z += mMass[i] * mZ[i];
+        }
+    else
+        for (std::uint32_t c = node.child; c < node.child + node.children; c++)
+        {
+            mass += nodes[c].mass;
+            x += nodes[c].mass * nodes[c].x;
+            y += nodes[c].mass * nodes[c].y;
+            z += nodes[c].mass * nodes[c].z;
+        }
+
+    glm::dvec3 centerOfMass = mass > 0.0 ? glm::dvec3(x, y, z) / mass : center;
+    node.x = centerOfMass.x;
+    node.y = centerOfMass.y;
+    node.z = centerOfMass.z;
+    node.mass = mass;
+
+    // Opening distance of the cell, widened by how far its mass sits off
+    // center so that no particle inside it is ever far enough to accept it
+    double size = mSize / static_cast<double>(1 << level);
+    node.reach = size / mTheta + glm::length(centerOfMass - center);
+}
+
+void NBodyEngine::accelerate()
+{
+    auto start = std::chrono::steady_clock::now();
+    sort();
+    build();
+    auto built = std::chrono::steady_clock::now();
+
+    std::atomic<std::size_t> interactions(0);
+    const double softening = mSoftening * mSoftening;
+    parallelFor(mLeaves.size(), leafGrain, [&](std::size_t first, std::size_t last) {
+        std::vector<std::uint32_t> stack;
+        std::vector<double> lx, ly, lz, lm;
+        std::size_t summed = 0;
+        for (std::size_t l = first; l < last; l++)
+        {
+            Node const & leaf = mNodes[mLeaves[l]];
+            glm::dvec3 low(std::numeric_limits<double>::max());
+            glm::dvec3 high(-std::numeric_limits<double>::max());
+            for (std::uint32_t i = leaf.begin; i < leaf.end; i++)
+            {
+                low = glm::min(low, glm::dvec3(mX[i], mY[i], mZ[i]));
+                high = glm::max(high, glm::dvec3(mX[i], mY[i], mZ[i]));
+            }
+
+            // Everything that pulls on the leaf: cells far from its box as
+            // point masses, the particles of the others one by one
+            lx.clear(); ly.clear(); lz.clear(); lm.clear();
+            stack.assign(1, 0);
+            while (!stack.empty())
+            {
+                Node const & node = mNodes[stack.back()];
+                stack.pop_back();
+                if (node.mass <= 0.0)
+                    continue;
+                glm::dvec3 com(node.x, node.y, node.z);
+                glm::dvec3 gap = glm::max(glm::max(low - com, com - high), glm::dvec3(0.0));
+                if (glm::dot(gap, gap) > node.reach * node.reach)
+                {
+                    lx.push_back(node.x);
+                    ly.push_back(node.y);
+                    lz.push_back(node.z);
+                    lm.push_back(node.mass);
+                }
+                else if (node.children == 0)
+                    for (std::uint32_t i = node.begin; i < node.end; i++)
+                    {
+                        if (mMass[i] <= 0.0)
+                            continue;
+                        lx.push_back(mX[i]);
+                        ly.push_back(mY[i]);
+                        lz.push_back(mZ[i]);
+                        lm.push_back(mMass[i]);
+                    }
+                else
+                    for (std::uint32_t c = node.child; c < node.child + node.children; c++)
+                        stack.push_back(c);
+            }
+
+            // A particle meets itself in the list at zero distance, where the
+            // softening makes its pull vanish
+            std::size_t size = lm.size();
+            for (std::uint32_t i = leaf.begin; i < leaf.end; i++)
+            {
+                double x = mX[i], y = mY[i], z = mZ[i];
+                double ax = 0.0, ay = 0.0, az = 0.0;
+                for (std::size_t j = 0; j < size; j++)
+                {
+                    double dx = lx[j] - x, dy = ly[j] - y, dz = lz[j] - z;
+                    double r2 = dx * dx + dy * dy + dz * dz + softening;
+                    double s = lm[j] / (r2 * std::sqrt(r2));
+                    ax += s * dx;
+                    ay += s * dy;
+                    az += s * dz;
+                }
+                mAX[i] = GaussianGravity * ax;
+                mAY[i] = GaussianGravity * ay;
+                mAZ[i] = GaussianGravity * az;
+            }
+            summed += size * (leaf.end - leaf.begin);
+        }
+        interactions += summed;
+    });
+    auto finished = std::chrono::steady_clock::now();
+
+    mStats.build = milliseconds(start, built);
+    mStats.forces = milliseconds(built, finished);
+    mStats.nodes = mNodes.size();
+    mStats.interactions = interactions;
+    mAccelerated = true;
+}
+
+void NBodyEngine::parallelFor(std::size_t count, std::size_t grain,
+                              std::function<void(std::size_t, std::size_t)> const & body)
+{
+    if (count == 0)
+        return;
+    if (mWorkers.empty() || count <= grain)
+    {
+        body(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = &body;
+        mJobCount = count;
+        mJobGrain = grain;
+        mJobNext = 0;
+        mBusy = static_cast<unsigned int>(mWorkers.size());
+        mGeneration++;
+    }
+    mJobReady.notify_all();
+
+    for (std::size_t begin; (begin = mJobNext.fetch_add(grain)) < count;)
+        body(begin, std::min(begin + grain, count));
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mJobDone.wait(lock, [this] { return mBusy == 0; });
+    mJob = nullptr;
+}
+
+void NBodyEngine::work()
+{
+    unsigned long seen = 0;
+    for (;;)
+    {
+        std::function<void(std::size_t, std::size_t)> const * job;
+        std::size_t count, grain;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobReady.wait(lock, [this, seen] { return mStopping || mGeneration != seen; });
+            if (mStopping)
+                return;
+            seen = mGeneration;
+            job = mJob;
+            count = mJobCount;
+            grain = mJobGrain;
+        }
+
+        for (std::size_t begin; (begin = mJobNext.fetch_add(grain)) < count;)
+            (*job)(begin, std::min(begin + grain, count));
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mBusy == 0)
+            mJobDone.notify_one();
+    }
+}
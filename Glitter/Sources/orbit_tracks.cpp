@@ -0,0 +1,212 @@
+// Local Headers
+#include "orbit_tracks.hpp"
+
+// System Headers
+#include <glm/gtc/constants.hpp>
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+
+// Largest distance, in pixels, allowed between a chord and the curve it cuts
+static const float tolerance = 0.5f;
+
+// How far past a threshold, as a factor of the size on screen, a track must
+// grow or shrink before its tessellation changes
+static const float hysteresis = 1.25f;
+
+// Levels from MinSegments to MaxSegments, doubling each time
+static const int levels = 9;
+
+// Coarsest level whose chords stay within the tolerance of a circle that
+// covers the given radius in pixels at its nearest point
+static int idealLevel(float pixelRadius)
+{
+    if (pixelRadius <= tolerance * 0.5f)
+        return 0;
+    float segments = glm::pi<float>() / std::acos(1.0f - tolerance / pixelRadius);
+    int level = 0;
+    while ((OrbitTracks::MinSegments << level) < segments && level < levels - 1)
+        level++;
+    return level;
+}
+
+OrbitTracks::OrbitTracks(std::size_t count, Sampler sampler)
+        : mSampler(sampler)
+        , mTracks(count)
+        , mFirsts(count)
+        , mCounts(count)
+        , mUsed(count * MinSegments)
+        , mCapacity(count * MinSegments)
+        , mUploads(0)
+{
+    mShader.attach("tracks.vert");
+    mShader.attach("tracks.frag");
+    mShader.link();
+
+    // One slot per track, as large as its coarsest tessellation
+    glGenVertexArrays(1, &mVertexArray);
+    glGenBuffers(1, &mBuffer);
+    glBindVertexArray(mVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), static_cast<void *>(nullptr));
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        mFirsts[i] = static_cast<GLint>(i * MinSegments);
+        mTracks[i].slot = MinSegments;
+        upload(i, 0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+OrbitTracks::~OrbitTracks()
+{
+    glDeleteVertexArrays(1, &mVertexArray);
+    glDeleteBuffers(1, &mBuffer);
+}
+
+void OrbitTracks::upload(std::size_t index, int level)
+{
+    int count = MinSegments << level;
+    mPoints.clear();
+    mSampler(index, count, mPoints);
+
+    // Measure the track as a circle about the centroid of its points
+    Track & track = mTracks[index];
+    track.center = glm::vec3(0.0f);
+    for (auto const & point : mPoints)
+        track.center += point;
+    track.center = track.center * (1.0f / count);
+    track.radius = 0.0f;
+    for (auto const & point : mPoints)
+        track.radius += glm::length(point - track.center);
+    track.radius /= static_cast<float>(count);
+    glm::vec3 normal = glm::cross(mPoints[0] - track.center, mPoints[count / 4] - track.center);
+    track.normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+    track.level = level;
+
+    reserve(index, count);
+    glBufferSubData(GL_ARRAY_BUFFER, mFirsts[index] * sizeof(glm::vec3), count * sizeof(glm::vec3), mPoints.data());
+    mCounts[index] = count;
+}
+
+void OrbitTracks::reserve(std::size_t index, int count)
+{
+    Track & track = mTracks[index];
+    if (count <= track.slot)
+        return;
+
+    // The old slot is left as a hole until the buffer is packed again
+    if (mUsed + count > mCapacity)
+        repack(index, count);
+    mFirsts[index] = static_cast<GLint>(mUsed);
+    track.slot = count;
+    mUsed += count;
+}
+
+// Copies every track but the one about to grow into a new buffer, packed in
+// order and each in a slot of its current size, with room left at the end
+// for as many vertices again.
+void OrbitTracks::repack(std::size_t index, int count)
+{
+    std::size_t live = count;
+    for (std::size_t i = 0; i < mTracks.size(); i++)
+        if (i != index)
+            live += mCounts[i];
+    mCapacity = live * 2;
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, mCapacity * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+
+    // Tracks that were next to each other are copied together
+    std::size_t used = 0;
+    GLint runFirst = 0;
+    std::size_t runStart = 0, runLength = 0;
+    for (std::size_t i = 0; i < mTracks.size(); i++)
+    {
+        std::size_t length = i == index ? 0 : mCounts[i];
+        if (runLength > 0 && mFirsts[i] != runFirst + static_cast<GLint>(runLength))
+        {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                runFirst * sizeof(glm::vec3), runStart * sizeof(glm::vec3), runLength * sizeof(glm::vec3));
+            runLength = 0;
+        }
+        if (runLength == 0)
+        {
+            runFirst = mFirsts[i];
+            runStart = used;
+        }
+        runLength += length;
+        mFirsts[i] = static_cast<GLint>(used);
+        mTracks[i].slot = static_cast<int>(length);
+        used += length;
+    }
+    if (runLength > 0)
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            runFirst * sizeof(glm::vec3), runStart * sizeof(glm::vec3), runLength * sizeof(glm::vec3));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    mUsed = used;
+
+    glDeleteBuffers(1, &mBuffer);
+    mBuffer = buffer;
+    glBindVertexArray(mVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), static_cast<void *>(nullptr));
+    glBindVertexArray(0);
+}
+
+void OrbitTracks::update(glm::vec3 const & eye, float pixelsPerUnit)
+{
+    mUploads = 0;
+    for (std::size_t i = 0; i < mTracks.size(); i++)
+    {
+        // Distance to the nearest point of the circle, from the eye's height
+        // above its plane and its distance from the circle within the plane
+        Track const & track = mTracks[i];
+        glm::vec3 offset = eye - track.center;
+        float height = glm::dot(offset, track.normal);
+        float across = glm::length(offset - height * track.normal) - track.radius;
+        float distance = std::max(std::sqrt(height * height + across * across), 1e-4f);
+        float pixels = track.radius / distance * pixelsPerUnit;
+
+        int finer = idealLevel(pixels / hysteresis);
+        int coarser = idealLevel(pixels * hysteresis);
+        int level = finer > track.level ? finer : coarser < track.level ? coarser : track.level;
+        if (level == track.level)
+            continue;
+
+        if (mUploads++ == 0)
+            glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+        upload(i, level);
+    }
+    if (mUploads > 0)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OrbitTracks::draw()
+{
+    if (mTracks.empty())
+        return;
+    mShader.activate();
+    mShader.bind("model", glm::mat4(1.0f));
+    mShader.bind("uColor", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    glBindVertexArray(mVertexArray);
+    glMultiDrawArrays(GL_LINE_LOOP, mFirsts.data(), mCounts.data(), static_cast<GLsizei>(mTracks.size()));
+    glBindVertexArray(0);
+}
+
+int OrbitTracks::segments() const
+{
+    int total = 0;
+    for (auto count : mCounts)
+        total += count;
+    return total;
+}
@@ -0,0 +1,55 @@
+// Local Headers
+#include "particle_cloud.hpp"
+
+// Standard Headers
+#include <algorithm>
+
+ParticleCloud::ParticleCloud(glm::vec4 const & color)
+        : mColor(color)
+        , mCapacity(0)
+        , mCount(0)
+{
+    // Plain positions in one color need nothing the track shaders lack
+    mShader.attach("tracks.vert");
+    mShader.attach("tracks.frag");
+    mShader.link();
+
+    glGenVertexArrays(1, &mVertexArray);
+    glGenBuffers(1, &mBuffer);
+    glBindVertexArray(mVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), static_cast<void *>(nullptr));
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ParticleCloud::~ParticleCloud()
+{
+    glDeleteVertexArrays(1, &mVertexArray);
+    glDeleteBuffers(1, &mBuffer);
+}
+
+void ParticleCloud::upload(std::vector<glm::vec3> const & points)
+{
+    mCount = points.size();
+    if (mCount == 0)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    mCapacity = std::max(mCapacity, mCount);
+    glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, mCount * sizeof(glm::vec3), points.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleCloud::draw()
+{
+    if (mCount == 0)
+        return;
+    mShader.activate();
+    mShader.bind("model", glm::mat4(1.0f));
+    mShader.bind("uColor", mColor);
+    glBindVertexArray(mVertexArray);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mCount));
+    glBindVertexArray(0);
+}
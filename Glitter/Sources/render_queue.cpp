@@ -0,0 +1,336 @@
+// Local Headers
+#include "render_queue.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cassert>
+
+// Field widths of the sort key, from the top
+static const int programBits = 8;
+static const int materialBits = 16;
+static const int meshBits = 16;
+static const int depthBits = 24;
+
+// Texture units tracked to skip rebinding a texture that is already in place
+static const int trackedUnits = 16;
+
+// Bytes of one index of each type a mesh may use
+static std::size_t indexSize(GLenum type)
+{
+    return type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+// Inverse transpose of a model matrix's upper 3x3: its cofactor matrix, whose
+// columns are cross products of the columns, over the determinant.
+static glm::mat3x4 normalMatrix(glm::mat4 const & model)
+{
+    glm::vec3 x(model[0]), y(model[1]), z(model[2]);
+    glm::vec3 yz = glm::cross(y, z);
+    float inverse = 1.0f / glm::dot(x, yz);
+    return glm::mat3x4(glm::vec4(yz * inverse, 0.0f),
+                       glm::vec4(glm::cross(z, x) * inverse, 0.0f),
+                       glm::vec4(glm::cross(x, y) * inverse, 0.0f));
+}
+
+RenderQueue::RenderQueue()
+        : mPlain(0)
+        , mFar(1.0f)
+        , mStats()
+        , mObjects(GL_TEXTURE_BUFFER)
+        , mDraws(GL_DRAW_INDIRECT_BUFFER)
+        , mObjectTexture(Mirage::TextureObject::create())
+        , mObjectBuffer(0)
+        , mFirstObject(0)
+        , mIndirect(GLAD_GL_VERSION_4_3 != 0)
+        , mBaseInstance(GLAD_GL_VERSION_4_2 != 0)
+{
+}
+
+RenderQueue::Id RenderQueue::program(Mirage::Shader & shader, char const * name, std::function<void(Mirage::Shader &)> setup)
+{
+    assert(mPrograms.size() < (std::size_t(1) << programBits));
+    Program program;
+    program.shader = & shader;
+    program.name = name;
+    program.setup = setup;
+    program.model = shader.uniform("model");
+    program.objects = shader.uniform("objects");
+    program.positionScale = shader.uniform("positionScale");
+    program.positionOffset = shader.uniform("positionOffset");
+    program.octahedralNormals = shader.uniform("octahedralNormals");
+    mPrograms.push_back(program);
+
+    // Sampler units are program state, so the objects buffer's is set once
+    if (program.objects >= 0)
+    {
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, & current);
+        shader.activate();
+        glUniform1i(program.objects, ObjectUnit);
+        glUseProgram(current);
+    }
+    return static_cast<Id>(mPrograms.size() - 1);
+}
+
+RenderQueue::Id RenderQueue::material(std::vector<Mirage::Texture> const & textures)
+{
+    // Keyed by what is bound, since paths are only unique within a model
+    std::vector<std::tuple<void const *, GLuint, GLint>> contents;
+    for (auto const & texture : textures)
+        contents.push_back(std::make_tuple(texture.handle.id(), texture.name, texture.unit));
+    auto found = mMaterialIds.find(contents);
+    if (found != mMaterialIds.end())
+        return found->second;
+
+    assert(mMaterials.size() < (std::size_t(1) << materialBits));
+    Id id = static_cast<Id>(mMaterials.size());
+    mMaterials.push_back(& textures);
+    mMaterialIds.emplace(contents, id);
+    return id;
+}
+
+RenderQueue::Id RenderQueue::mesh(Mirage::Mesh & mesh)
+{
+    return this->mesh(mesh, 0, mesh.indexCount());
+}
+
+RenderQueue::Id RenderQueue::mesh(Mirage::Mesh & mesh, GLuint firstIndex, GLsizei indexCount)
+{
+    assert(mMeshes.size() < (std::size_t(1) << meshBits));
+    Range range = { & mesh, firstIndex, indexCount };
+    mMeshes.push_back(range);
+    return static_cast<Id>(mMeshes.size() - 1);
+}
+
+void RenderQueue::begin(float farPlane)
+{
+    mFar = farPlane;
+    mCommands.clear();
+    mOrder.clear();
+    mPlain = 0;
+}
+
+std::uint64_t RenderQueue::key(Id program, Id material, Id mesh, float depth) const
+{
+    const std::uint32_t deepest = (1u << depthBits) - 1;
+    float scaled = std::max(depth, 0.0f) / mFar * deepest;
+    std::uint32_t quantized = scaled < deepest ? static_cast<std::uint32_t>(scaled) : deepest;
+    return (std::uint64_t(program)  << (materialBits + meshBits + depthBits))
+         | (std::uint64_t(material) << (meshBits + depthBits))
+         | (std::uint64_t(mesh)     << depthBits)
+         | quantized;
+}
+
+void RenderQueue::submit(Id program, Id material, Id mesh, glm::mat4 const & model, float depth)
+{
+    submit(program, material, mesh, model, normalMatrix(model), depth);
+}
+
+void RenderQueue::submit(Id program, Id material, Id mesh, glm::mat4 const & model, glm::mat3x4 const & normal,
+                         float depth)
+{
+    Command command = { model, normal, program, material, mesh, 0, 1, 0 };
+    mPlain++;
+    mOrder.push_back(std::make_pair(key(program, material, mesh, depth),
+                                    static_cast<std::uint32_t>(mCommands.size())));
+    mCommands.push_back(command);
+}
+
+void RenderQueue::submit(Id program, Id material, Id mesh, glm::mat4 const & model, float depth,
+                         GLuint instances, GLsizei count, GLsizei first)
+{
+    Command command = { model, glm::mat3x4(1.0f), program, material, mesh, instances, count, first };
+    if (!instances)
+    {
+        command.normal = normalMatrix(model);
+        mPlain++;
+    }
+    mOrder.push_back(std::make_pair(key(program, material, mesh, depth),
+                                    static_cast<std::uint32_t>(mCommands.size())));
+    mCommands.push_back(command);
+}
+
+void RenderQueue::writeObjects()
+{
+    // Objects go in draw order, so a run of draws is a run of base instances.
+    // They start at the first whole object of the region, whose size is not
+    // a multiple of theirs.
+    auto region = static_cast<unsigned char *>(mObjects.begin((mPlain + 1) * sizeof(Object)));
+    std::size_t skip = (sizeof(Object) - mObjects.offset() % sizeof(Object)) % sizeof(Object);
+    auto objects = reinterpret_cast<Object *>(region + skip);
+    auto draws = mIndirect ? static_cast<DrawCommand *>(mDraws.begin(mPlain * sizeof(DrawCommand))) : nullptr;
+    mFirstObject = static_cast<GLuint>((mObjects.offset() + skip) / sizeof(Object));
+
+    // A grown buffer needs the texture over it and an index for each object
+    if (mObjects.buffer() != mObjectBuffer)
+    {
+        mObjectBuffer = mObjects.buffer();
+        glBindTexture(GL_TEXTURE_BUFFER, mObjectTexture.get());
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mObjectBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        std::vector<GLuint> indices(mObjects.size() / sizeof(Object));
+        for (std::size_t i = 0; i < indices.size(); i++)
+            indices[i] = static_cast<GLuint>(i);
+        mObjectIndices = Mirage::Buffer::create();
+        glBindBuffer(GL_ARRAY_BUFFER, mObjectIndices.get());
+        glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    std::size_t written = 0;
+    for (auto const & entry : mOrder)
+    {
+        Command const & command = mCommands[entry.second];
+        if (command.instances)
+            continue;
+        Object & object = objects[written];
+        object.model = command.model;
+        object.normal = command.normal;
+
+        if (draws)
+        {
+            Range const & range = mMeshes[command.mesh];
+            DrawCommand & draw = draws[written];
+            draw.count = static_cast<GLuint>(range.indexCount);
+            draw.instanceCount = 1;
+            draw.firstIndex = range.firstIndex;
+            draw.baseVertex = 0;
+            draw.baseInstance = mFirstObject + static_cast<GLuint>(written);
+        }
+        written++;
+    }
+    mObjects.flush(skip + written * sizeof(Object));
+    if (draws) mDraws.flush(written * sizeof(DrawCommand));
+}
+
+void RenderQueue::drawRun(std::size_t begin, std::size_t end, std::size_t plain)
+{
+    GLenum type = mMeshes[mCommands[mOrder[begin].second].mesh].mesh->indexType();
+    if (mIndirect)
+    {
+        // The commands of the run sit at the same positions as its objects
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mDraws.buffer());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, type,
+                                    (void*)(mDraws.offset() + plain * sizeof(DrawCommand)),
+                                    static_cast<GLsizei>(end - begin), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        mStats.calls++;
+        return;
+    }
+
+    // Without indirect draws each draw of the run is a call of its own
+    std::size_t size = indexSize(type);
+    for (std::size_t i = begin; i < end; i++)
+    {
+        Range const & part = mMeshes[mCommands[mOrder[i].second].mesh];
+        GLuint object = mFirstObject + static_cast<GLuint>(plain + i - begin);
+        void * indices = (void*)(part.firstIndex * size);
+        if (mBaseInstance)
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, part.indexCount, type, indices, 1, object);
+        else
+        {
+            glVertexAttribI4ui(12, object, 0, 0, 0);
+            glDrawElements(GL_TRIANGLES, part.indexCount, type, indices);
+        }
+        mStats.calls++;
+    }
+}
+
+void RenderQueue::execute()
+{
+    mStats = Stats();
+    std::sort(mOrder.begin(), mOrder.end());
+    writeObjects();
+    glActiveTexture(GL_TEXTURE0 + ObjectUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, mObjectTexture.get());
+
+    // What is bound right now; -1 until the first draw binds it
+    Mirage::Profiler & profiler = Mirage::Profiler::global();
+    int program = -1, material = -1, pass = -1;
+    Mirage::Mesh * arrays = nullptr;
+    glm::mat4 model;
+    bool modelSet = false;
+    GLuint units[trackedUnits] = {};
+    std::size_t plain = 0;
+    for (std::size_t i = 0; i < mOrder.size(); )
+    {
+        Command const & command = mCommands[mOrder[i].second];
+        Program const & current = mPrograms[command.program];
+        if (command.program != program)
+        {
+            profiler.endGpu(pass);
+            pass = profiler.beginGpu(current.name);
+            current.shader->activate();
+            if (current.setup) current.setup(*current.shader);
+            program = command.program;
+            arrays = nullptr; // the decode uniforms belong to the program
+            modelSet = false;
+            mStats.programs++;
+        }
+
+        if (command.material != material)
+        {
+            for (auto const & texture : *mMaterials[command.material])
+            {
+                if (texture.unit < 0) continue;
+                GLuint name = texture.handle ? texture.handle.use() : texture.name;
+                if (texture.unit < trackedUnits && units[texture.unit] == name) continue;
+                glActiveTexture(GL_TEXTURE0 + texture.unit);
+                glBindTexture(GL_TEXTURE_2D, name);
+                if (texture.unit < trackedUnits) units[texture.unit] = name;
+            }
+            material = command.material;
+            mStats.materials++;
+        }
+
+        Range const & range = mMeshes[command.mesh];
+        Mirage::Mesh & geometry = *range.mesh;
+        if (range.mesh != arrays)
+        {
+            glBindVertexArray(geometry.vertexArray());
+            glUniform3fv(current.positionScale, 1, & geometry.positionScale()[0]);
+            glUniform3fv(current.positionOffset, 1, & geometry.positionOffset()[0]);
+            glUniform1i(current.octahedralNormals, geometry.octahedralNormals());
+            if (mBaseInstance && current.objects >= 0) geometry.bindObjects(mObjectIndices.get());
+            arrays = range.mesh;
+            mStats.vertexArrays++;
+        }
+
+        if (command.instances)
+        {
+            // Instanced runs of one object share its matrix
+            if (!modelSet || command.model != model)
+            {
+                glUniformMatrix4fv(current.model, 1, GL_FALSE, & command.model[0][0]);
+                model = command.model;
+                modelSet = true;
+            }
+            geometry.drawElementsInstanced(command.instances, command.count, command.first);
+            mStats.draws++;
+            mStats.calls++;
+            i++;
+            continue;
+        }
+
+        // Plain draws that follow with the same state join the run
+        std::size_t end = i + 1;
+        for (; end < mOrder.size(); end++)
+        {
+            Command const & next = mCommands[mOrder[end].second];
+            if (next.instances || next.program != command.program || next.material != command.material
+                || mMeshes[next.mesh].mesh != range.mesh)
+                break;
+        }
+        drawRun(i, end, plain);
+        mStats.draws += static_cast<int>(end - i);
+        plain += end - i;
+        i = end;
+    }
+    profiler.endGpu(pass);
+    mObjects.end();
+    if (mIndirect) mDraws.end();
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
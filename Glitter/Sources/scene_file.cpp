@@ -0,0 +1,381 @@
+// Local Headers
+#include "scene_file.hpp"
+
+// Sample Headers
+#include <mapped_file.hpp>
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+const char * const SceneFile::DefaultPath = "Scenes/solar_system.scene";
+
+// The words of one line of a scene file, comment excluded, read in turn
+class Words
+{
+public:
+
+    Words(char const * begin, char const * end) : mNext(begin), mEnd(end) {}
+
+    bool word(std::string & out)
+    {
+        skip();
+        char const * start = mNext;
+        while (mNext < mEnd && !space(*mNext))
+            mNext++;
+        out.assign(start, mNext);
+        return mNext > start;
+    }
+
+    // A number, in kilometers if it is a distance in astronomical units
+    bool number(double & out)
+    {
+        skip();
+        char const * start = mNext;
+        while (mNext < mEnd && !space(*mNext))
+            mNext++;
+        if (mNext == start || mNext - start > 63)
+            return false;
+        char text[64];
+        std::memcpy(text, start, mNext - start);
+        text[mNext - start] = '\0';
+        char * rest;
+        out = std::strtod(text, & rest);
+        if (rest == text)
+            return false;
+        if (std::strcmp(rest, "au") == 0)
+            out *= AU;
+        else if (*rest)
+            return false;
+        return true;
+    }
+
+    bool number(float & out)
+    {
+        double value;
+        if (!number(value)) return false;
+        out = static_cast<float>(value);
+        return true;
+    }
+
+    bool count(int & out)
+    {
+        double value;
+        if (!number(value) || value < 0.0 || value > std::numeric_limits<int>::max() || value != std::floor(value))
+            return false;
+        out = static_cast<int>(value);
+        return true;
+    }
+
+    bool vector(glm::vec3 & out)
+    {
+        return number(out.x) && number(out.y) && number(out.z);
+    }
+
+    // Everything left, for paths that may hold spaces
+    bool rest(std::string & out)
+    {
+        skip();
+        char const * end = mEnd;
+        while (end > mNext && space(end[-1]))
+            end--;
+        out.assign(mNext, end);
+        mNext = mEnd;
+        return !out.empty();
+    }
+
+    bool done()
+    {
+        skip();
+        return mNext == mEnd;
+    }
+
+private:
+
+    static bool space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    void skip() { while (mNext < mEnd && space(*mNext)) mNext++; }
+
+    char const * mNext;
+    char const * mEnd;
+};
+
+bool SceneFile::load(std::string const & path)
+{
+    bodies.clear();
+    belt = Belt();
+    populations.clear();
+
+    Mirage::MappedFile file(path);
+    if (!file.valid())
+    {
+        fprintf(stderr, "Failed to Open Scene %s\n", path.c_str());
+        return false;
+    }
+
+    // Properties belong to the block opened last
+    enum { None, InBody, InBelt, InPopulation } block = None;
+    std::unordered_map<std::string, int> names;
+    int number = 0;
+    std::string error;
+    auto close = [&]() {
+        if (block == InBody && bodies.back().model.empty() == bodies.back().surface.empty())
+            error = "body " + bodies.back().name + " needs either a model or a surface";
+        if (block == InBelt && belt.rocks > 0 && (belt.outer <= belt.inner || belt.period <= 0.0))
+            error = "belt needs radii and a period";
+        if (block == InPopulation && populations.back().outer <= populations.back().inner)
+            error = "population " + populations.back().name + " needs radii";
+    };
+
+    char const * text = reinterpret_cast<char const *>(file.data());
+    char const * end = text + file.size();
+    std::string key, name;
+    for (char const * line = text; line < end && error.empty(); )
+    {
+        char const * next = std::find(line, end, '\n');
+        Words words(line, std::find(line, next, '#'));
+        line = next + 1;
+        number++;
+        if (!words.word(key))
+            continue;
+
+        bool valid = true;
+        if (key == "body" || key == "belt" || key == "population")
+        {
+            close();
+            if (!error.empty()) break;
+            if (key == "body")
+            {
+                if (!words.word(name) || !words.done())
+                    error = "body needs a name";
+                else if (!names.emplace(name, static_cast<int>(bodies.size())).second)
+                    error = "body " + name + " is defined twice";
+                bodies.push_back(Body());
+                bodies.back().name = name;
+                block = InBody;
+            }
+            else if (key == "belt")
+            {
+                if (!words.done())
+                    error = "belt takes no name";
+                block = InBelt;
+            }
+            else
+            {
+                if (!words.word(name) || !words.done())
+                    error = "population needs a name";
+                populations.push_back(Population());
+                populations.back().name = name;
+                block = InPopulation;
+            }
+            continue;
+        }
+        else if (block == InBody)
+        {
+            Body & body = bodies.back();
+            OrbitalElements & e = body.elements;
+            if (key == "model" || key == "surface")
+                valid = words.rest(key == "model" ? body.model : body.surface);
+            else if (key == "parent")
+            {
+                auto found = names.find(words.word(name) ? name : std::string());
+                if (found == names.end() || found->second + 1 == static_cast<int>(bodies.size()))
+                    error = "parent " + name + " is not a body defined before";
+                else
+                    body.parent = found->second;
+            }
+            else if (key == "orbit")
+                valid = words.number(e.semiMajorAxis) && words.number(e.eccentricity)
+                     && words.number(e.inclination) && words.number(e.meanLongitude)
+                     && words.number(e.perihelionLongitude) && words.number(e.ascendingNode);
+            else if (key == "rates")
+                valid = words.number(e.semiMajorAxisRate) && words.number(e.eccentricityRate)
+                     && words.number(e.inclinationRate) && words.number(e.meanLongitudeRate)
+                     && words.number(e.perihelionLongitudeRate) && words.number(e.ascendingNodeRate);
+            else if (key == "mass")
+                valid = words.number(body.mass);
+            else if (key == "offset")
+                valid = words.number(body.offset);
+            else if (key == "spin")
+                valid = words.number(body.spin) && words.vector(body.spinAxis);
+            else if (key == "tilt")
+                valid = words.number(body.tilt) && words.vector(body.tiltAxis);
+            else if (key == "scale")
+                valid = words.number(body.scale);
+            else
+                error = "unknown body property " + key;
+        }
+        else if (block == InBelt)
+        {
+            if (key == "radii")
+                valid = words.number(belt.inner) && words.number(belt.outer);
+            else if (key == "period")
+                valid = words.number(belt.period);
+            else if (key == "offset")
+                valid = words.number(belt.offset);
+            else if (key == "rocks")
+                valid = words.count(belt.rocks);
+            else
+                error = "unknown belt property " + key;
+        }
+        else if (block == InPopulation)
+        {
+            Population & population = populations.back();
+            if (key == "center")
+            {
+                auto found = names.find(words.word(name) ? name : std::string());
+                if (found == names.end())
+                    error = "center " + name + " is not a body defined before";
+                else
+                    population.center = found->second;
+            }
+            else if (key == "radii")
+                valid = words.number(population.inner) && words.number(population.outer);
+            else if (key == "inclination")
+                valid = words.number(population.inclination);
+            else if (key == "mass")
+                valid = words.number(population.mass);
+            else if (key == "offset")
+                valid = words.number(population.offset);
+            else if (key == "tilt")
+                valid = words.number(population.tilt);
+            else if (key == "particles")
+                valid = words.count(population.particles);
+            else
+                error = "unknown population property " + key;
+        }
+        else
+            error = key + " is outside of any block";
+
+        if (error.empty() && (!valid || !words.done()))
+            error = "malformed " + key;
+    }
+    if (error.empty())
+        close();
+    if (error.empty() && bodies.empty())
+        error = "no bodies";
+    if (error.empty() && bodies[0].mass <= 0.0)
+        error = "the first body needs a mass";
+
+    if (!error.empty())
+    {
+        fprintf(stderr, "%s:%d: %s\n", path.c_str(), number, error.c_str());
+        bodies.clear();
+        belt = Belt();
+        populations.clear();
+        return false;
+    }
+    return true;
+}
+
+// Writes the shortest text a value reads back from, as a double or a float
+static void write(FILE * file, char const * prefix, double value, bool single = false)
+{
+    // A value that reads back at some precision does at every higher one
+    char text[32];
+    int low = 1, high = single ? 9 : 17;
+    while (low < high)
+    {
+        int precision = (low + high) / 2;
+        snprintf(text, sizeof(text), "%.*g", precision, value);
+        double read = std::strtod(text, nullptr);
+        if (single ? static_cast<float>(read) == static_cast<float>(value) : read == value)
+            high = precision;
+        else
+            low = precision + 1;
+    }
+    fprintf(file, "%s%.*g", prefix, low, value);
+}
+
+static void write(FILE * file, char const * prefix, glm::vec3 const & value)
+{
+    write(file, prefix, value.x, true);
+    write(file, " ", value.y, true);
+    write(file, " ", value.z, true);
+}
+
+bool SceneFile::save(std::string const & path) const
+{
+    FILE * file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    OrbitalElements const none = {};
+    for (auto const & body : bodies)
+    {
+        OrbitalElements const & e = body.elements;
+        fprintf(file, "body %s\n", body.name.c_str());
+        if (!body.model.empty())
+            fprintf(file, "    model %s\n", body.model.c_str());
+        if (!body.surface.empty())
+            fprintf(file, "    surface %s\n", body.surface.c_str());
+        if (body.parent >= 0)
+            fprintf(file, "    parent %s\n", bodies[body.parent].name.c_str());
+        if (std::memcmp(& e, & none, sizeof(e)) != 0)
+        {
+            write(file, "    orbit ", e.semiMajorAxis);
+            write(file, " ", e.eccentricity);
+            write(file, " ", e.inclination);
+            write(file, " ", e.meanLongitude);
+            write(file, " ", e.perihelionLongitude);
+            write(file, " ", e.ascendingNode);
+            write(file, "\n    rates ", e.semiMajorAxisRate);
+            write(file, " ", e.eccentricityRate);
+            write(file, " ", e.inclinationRate);
+            write(file, " ", e.meanLongitudeRate);
+            write(file, " ", e.perihelionLongitudeRate);
+            write(file, " ", e.ascendingNodeRate);
+            fprintf(file, "\n");
+        }
+        write(file, "    mass ", body.mass);
+        write(file, "\n    offset ", body.offset, true);
+        write(file, "\n    spin ", body.spin, true);
+        write(file, " ", body.spinAxis);
+        write(file, "\n    tilt ", body.tilt, true);
+        write(file, " ", body.tiltAxis);
+        write(file, "\n    scale ", body.scale, true);
+        fprintf(file, "\n");
+    }
+    if (belt.rocks > 0 || belt.outer > belt.inner)
+    {
+        write(file, "belt\n    radii ", belt.inner);
+        write(file, " ", belt.outer);
+        write(file, "\n    period ", belt.period);
+        write(file, "\n    offset ", belt.offset, true);
+        fprintf(file, "\n    rocks %d\n", belt.rocks);
+    }
+    for (auto const & population : populations)
+    {
+        fprintf(file, "population %s\n", population.name.c_str());
+        fprintf(file, "    center %s\n", bodies[population.center].name.c_str());
+        write(file, "    radii ", population.inner);
+        write(file, " ", population.outer);
+        write(file, "\n    inclination ", population.inclination);
+        write(file, "\n    mass ", population.mass);
+        write(file, "\n    offset ", population.offset, true);
+        write(file, "\n    tilt ", population.tilt);
+        fprintf(file, "\n    particles %d\n", population.particles);
+    }
+    bool written = !ferror(file);
+    return fclose(file) == 0 && written;
+}
+
+int SceneFile::findPopulation(std::string const & name) const
+{
+    for (std::size_t i = 0; i < populations.size(); i++)
+        if (populations[i].name == name)
+            return static_cast<int>(i);
+    return -1;
+}
+
+std::uint64_t SceneFile::elementsKey() const
+{
+    std::uint64_t key = Mirage::hash(nullptr, 0);
+    for (auto const & body : bodies)
+        key = Mirage::hash(& body.elements, sizeof(body.elements), key);
+    return key;
+}
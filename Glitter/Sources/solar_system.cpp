@@ -0,0 +1,823 @@
+// Local Headers
+#include "solar_system.hpp"
+
+// System Headers
+#include <glm/gtc/constants.hpp>
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+static const float rotationSpeedScale = 1.0f;
+
+// Depth range of the projection
+static const float nearPlane = 0.1f;
+static const float farPlane = 8000.0f;
+
+static const float scalingCoef = 0.0000005f;
+
+// Simulated days per second of wall-clock time, close to the old per-frame pace
+static const double defaultTimeWarp = 3.5;
+
+// Radius of the shared sphere meshes in model units, which the scales of the
+// default scene turn into 100 units for the Sun and 10 for the planets
+static const float sphereRadius = 100.0f;
+
+// Leapfrog step of the gravity mode, in days: about a twelfth of the orbit of
+// the innermost ring particles, which take under six hours. A date further
+// ahead than reseedSpan, or behind, restarts the mode from the orbits at that
+// date instead of stepping to it.
+static const double gravityStep = 0.02;
+static const double reseedSpan = 30.0;
+
+// Below this many bodies one batched frustum test over all of them beats
+// walking a tree; above it the tree is refitted every frame and rebuilt
+// every so many frames.
+static const std::size_t bodyTreeThreshold = 256;
+static const int bodyTreeRebuild = 120;
+
+// Maps a position in kilometers along the ecliptic axes into the scene: the
+// distance is scaled down and pushed out by an offset so that the inner
+// planets clear the Sun, and the ecliptic north pole becomes the world's +Y.
+static glm::vec3 toWorld(glm::dvec3 const & position, float offset)
+{
+    double distance = glm::length(position);
+    if (distance <= 0.0) return glm::vec3(0.0f);
+    double factor = (distance * scalingCoef + offset) / distance;
+    return glm::vec3(position.x * factor, position.z * factor, -position.y * factor);
+}
+
+static glm::dvec3 rotateX(glm::dvec3 const & v, double angle)
+{
+    double c = std::cos(angle), s = std::sin(angle);
+    return glm::dvec3(v.x, c * v.y - s * v.z, s * v.y + c * v.z);
+}
+
+static glm::dvec3 rotateZ(glm::dvec3 const & v, double angle)
+{
+    double c = std::cos(angle), s = std::sin(angle);
+    return glm::dvec3(c * v.x - s * v.y, s * v.x + c * v.y, v.z);
+}
+
+static const float skyboxVertices[] = {
+        // positions
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        -1.0f,  1.0f, -1.0f,
+        1.0f,  1.0f, -1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f
+};
+
+SolarSystem::SolarSystem(SceneFile const & scene)
+        : mScene(scene)
+        , mSun(0)
+        , mEpoch(J2000)
+        , mTimeWarp(defaultTimeWarp)
+        , mTime(0.0f)
+        , mStarted(false)
+        , mGravityEpoch(J2000)
+        , mRunning(false)
+        , mSeek(-1.0)
+        , mTickLength(0.0)
+        , mTreeAge(0)
+        , mCounters()
+{
+    mPlanetShader.attach("shader.vert");
+    mPlanetShader.attach("shader.frag");
+    mPlanetShader.attach("surface.frag");
+    mPlanetShader.link().activate();
+
+    mSkyboxShader.attach("skybox.vert");
+    mSkyboxShader.attach("skybox.frag");
+    mSkyboxShader.link().activate();
+
+    mSunShader.attach("shader.vert");
+    mSunShader.attach("light_source.frag");
+    mSunShader.attach("surface.frag");
+    mSunShader.link().activate();
+
+    /* SKYBOX GENERATION */
+    glGenVertexArrays(1, &mSkyboxVAO);
+    glGenBuffers(1, &mSkyboxVBO);
+    glBindVertexArray(mSkyboxVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mSkyboxVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    /* SKYBOX GENERATION */
+
+    std::vector<std::string> faces
+            {
+                     "Skybox/starfield_bk.tga",
+                     "Skybox/starfield_dn.tga",
+                     "Skybox/starfield_ft.tga",
+                     "Skybox/starfield_lf.tga",
+                     "Skybox/starfield_rt.tga",
+                     "Skybox/starfield_up.tga"
+            };
+
+    // Parse models and decode images on every core; GL objects are created as they arrive
+    Mirage::AssetLoader loader;
+    mCubemap = loadCubemap(faces, loader);
+
+    // Camera matrices shared by every program through the Camera block
+    glGenBuffers(1, &mCameraBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, mCameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // One set of sphere meshes for every spherical body, and one set of
+    // textures for every map, however many bodies share it
+    mSphere.reset(new Icosphere(sphereRadius));
+    mSurfaceOf.assign(mScene.bodies.size(), -1);
+    mLevels.assign(mScene.bodies.size(), 0);
+    std::unordered_map<std::string, int> maps;
+
+    for (std::size_t i = 0; i < mScene.bodies.size(); i++)
+    {
+        SceneFile::Body const & info = mScene.bodies[i];
+        Body body;
+        body.parent = info.parent;
+        body.spinRate = glm::radians(info.spin * rotationSpeedScale);
+        body.spinAxis = info.spinAxis;
+        body.tilt = glm::radians(info.tilt);
+        body.tiltAxis = info.tiltAxis;
+        body.scale = info.scale;
+        mBodies.add(body);
+        mOrbits.add(info.elements);
+        mOffsets.push_back(info.offset);
+        if (!info.model.empty())
+        {
+            mModels.push_back(std::unique_ptr<Model>(new Model(info.model, loader, Mirage::VertexFormat::Compact)));
+            continue;
+        }
+        mModels.push_back(nullptr);
+        auto found = maps.find(info.surface);
+        if (found != maps.end())
+        {
+            mSurfaceOf[i] = found->second;
+            continue;
+        }
+        int index = static_cast<int>(mSurfaces.size());
+        maps.emplace(info.surface, index);
+        mSurfaceOf[i] = index;
+        mSurfaces.emplace_back();
+        mVirtualMaps.push_back(-1);
+
+        // Decode the map on a worker unless the texture cache already has it;
+        // large maps are cut into tiles instead, streamed in as they are seen
+        std::string file = info.surface;
+        loader.async([this, index, file, &loader] {
+            auto tiles = std::make_shared<Mirage::TileFile>(file);
+            if (!tiles->valid())
+                tiles.reset();
+            std::shared_ptr<Mirage::MipChain> mips;
+            if (!tiles && !Mirage::TextureCache::global().contains(file))
+                mips = std::make_shared<Mirage::MipChain>(file);
+            loader.upload([this, index, file, mips, tiles] {
+                if (tiles)
+                {
+                    if (!mVirtual)
+                        mVirtual.reset(new Mirage::VirtualTextures());
+                    int id = mVirtual->add(tiles);
+                    if (id >= 0)
+                    {
+                        mVirtualMaps[index] = id;
+                        mSurfaces[index] = mVirtual->material(id);
+                        return;
+                    }
+                }
+                Mirage::TextureCache & cache = Mirage::TextureCache::global();
+                Mirage::Texture texture;
+                texture.handle = mips ? cache.acquire(file, mips) : cache.acquire(file);
+                texture.type = "texture_diffuse";
+                texture.path = file;
+                mSurfaces[index].assign(1, texture);
+                Mirage::assignUnits(mSurfaces[index]);
+            });
+        });
+    }
+
+    SceneFile::Belt const & belt = mScene.belt;
+    if (belt.rocks > 0)
+        mBelt.reset(new AsteroidBelt(mQueue, belt.rocks,
+                                     static_cast<float>(belt.inner * scalingCoef) + belt.offset,
+                                     static_cast<float>(belt.outer * scalingCoef) + belt.offset));
+
+    mX.resize(mOrbits.size());
+    mY.resize(mOrbits.size());
+    mZ.resize(mOrbits.size());
+
+    // Orbit tracks of the bodies that go around the Sun, sampled with the
+    // elements of the date they are tessellated at
+    std::vector<std::size_t> tracked;
+    for (std::size_t i = 0; i < mOrbits.size(); i++)
+        if (mScene.bodies[i].parent < 0 && mScene.bodies[i].elements.semiMajorAxis > 0.0)
+            tracked.push_back(i);
+    mTracks.reset(new OrbitTracks(tracked.size(), [this, tracked](std::size_t track, int count,
+                                                                  std::vector<glm::vec3> & points) {
+        std::size_t body = tracked[track];
+        mOrbits.sample(body, mEpoch, count, mTrackSamples);
+        for (auto const & point : mTrackSamples)
+            points.push_back(toWorld(point, mOffsets[body]));
+    }));
+
+    glLineWidth(20);
+
+    // Upload whatever the workers produced while the rest was being built
+    loader.finish();
+
+    // Every mesh and material exists now; the queue refers to them by id
+    mPlanetProgram = mQueue.program(mPlanetShader, "planets", [this](Mirage::Shader & shader) {
+        shader.bind("lightPos", mBodies.position(mSun));
+    });
+    mSunProgram = mQueue.program(mSunShader, "sun");
+    if (mVirtual)
+    {
+        mVirtualPlanetShader.attach("shader.vert").attach("shader.frag").attach("virtual_surface.frag").link();
+        mVirtualSunShader.attach("shader.vert").attach("light_source.frag").attach("virtual_surface.frag").link();
+        mFeedbackShader.attach("virtual_feedback.vert").attach("virtual_feedback.frag").link();
+        mVirtualPlanetProgram = mQueue.program(mVirtualPlanetShader, "planets (tiled)", [this](Mirage::Shader & shader) {
+            shader.bind("lightPos", mBodies.position(mSun));
+        });
+        mVirtualSunProgram = mQueue.program(mVirtualSunShader, "sun (tiled)");
+    }
+    for (int level = 0; level < Icosphere::Levels; level++)
+        mSphereMeshes[level] = mQueue.mesh(mSphere->mesh(), mSphere->firstIndex(level), mSphere->indexCount(level));
+    for (auto const & surface : mSurfaces)
+        mSurfaceMaterials.push_back(mQueue.material(surface));
+    mParts.resize(mModels.size());
+    for (std::size_t i = 0; i < mModels.size(); i++)
+    {
+        if (!mModels[i])
+            continue;
+        for (auto & mesh : mModels[i]->meshes)
+        {
+            Part part = { mQueue.mesh(mesh), mQueue.material(mesh.textures) };
+            mParts[i].push_back(part);
+        }
+    }
+}
+
+SolarSystem::~SolarSystem()
+{
+    stopSimulation();
+
+    // Return the model textures while the context is still current
+    mModels.clear();
+    mSurfaces.clear();
+    mVirtual.reset();
+    Mirage::TextureCache::global().clear();
+
+    glDeleteVertexArrays(1, &mSkyboxVAO);
+    glDeleteBuffers(1, &mSkyboxVBO);
+    glDeleteTextures(1, &mCubemap);
+    glDeleteBuffers(1, &mCameraBuffer);
+}
+
+void SolarSystem::update(float time)
+{
+    Mirage::Profiler::GpuScope scope("update");
+
+    // Advance the simulated date by the wall-clock time elapsed since the last update
+    if (mStarted)
+        mEpoch += (time - mTime) * mTimeWarp;
+    mTime = time;
+    mStarted = true;
+
+    propagate(mEpoch, mPositions, mParticles);
+    for (std::size_t i = 0; i < mBodies.size(); i++)
+        mBodies.setOffset(i, mPositions[i]);
+    mBodies.update(time);
+    if (mCloud) mCloud->upload(mParticles);
+}
+
+void SolarSystem::propagate(double epoch, std::vector<glm::vec3> & offsets, std::vector<glm::vec3> & particles)
+{
+    Mirage::Profiler::Scope scope("propagate");
+    if (mGravity)
+    {
+        gravitate(epoch, offsets, particles);
+        return;
+    }
+    if (mEphemeris.covers(epoch))
+        mEphemeris.positions(epoch, mX.data(), mY.data(), mZ.data());
+    else
+        mOrbits.propagate(epoch, mX.data(), mY.data(), mZ.data());
+    offsets.resize(mOrbits.size());
+    for (std::size_t i = 0; i < offsets.size(); i++)
+        offsets[i] = toWorld(glm::dvec3(mX[i], mY[i], mZ[i]), mOffsets[i]);
+}
+
+bool SolarSystem::useEphemeris(std::string const & path)
+{
+    return mEphemeris.open(path, mScene.elementsKey()) && mEphemeris.size() == mOrbits.size();
+}
+
+bool SolarSystem::writeEphemeris(SceneFile const & scene, std::string const & path,
+                                 double from, double to, double * maxError)
+{
+    KeplerPropagator orbits;
+    for (auto const & info : scene.bodies)
+        orbits.add(info.elements);
+    Ephemeris::Source source = [&orbits](double julianDate, double * x, double * y, double * z) {
+        orbits.propagate(julianDate, x, y, z);
+    };
+    return Ephemeris::generate(path, scene.elementsKey(), orbits.size(), source, from, to, 32.0, 12, 1.0, maxError);
+}
+
+void SolarSystem::useGravity()
+{
+    mGravity.reset(new NBodyEngine());
+    mPopulation.clear();
+    for (auto const & population : mScene.populations)
+        mPopulation.push_back(population.particles);
+    if (std::accumulate(mPopulation.begin(), mPopulation.end(), 0LL) > 0)
+        mCloud.reset(new ParticleCloud(glm::vec4(0.8f, 0.75f, 0.65f, 1.0f)));
+    seedGravity(mEpoch);
+}
+
+void SolarSystem::seedGravity(double epoch)
+{
+    // Every body where its orbit puts it, relative to the Sun in astronomical
+    // units, at a date
+    std::size_t count = mOrbits.size();
+    auto place = [this, count](double date, std::vector<glm::dvec3> & positions) {
+        mOrbits.propagate(date, mX.data(), mY.data(), mZ.data());
+        positions.resize(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            positions[i] = glm::dvec3(mX[i], mY[i], mZ[i]) * (1.0 / AU);
+            if (mScene.bodies[i].parent >= 0)
+                positions[i] += positions[mScene.bodies[i].parent];
+        }
+    };
+
+    // Velocities by central differences, with the Sun's set so that the
+    // system as a whole stays at rest
+    const double h = 0.01;
+    std::vector<glm::dvec3> positions, before, after;
+    place(epoch, positions);
+    place(epoch - h, before);
+    place(epoch + h, after);
+    std::vector<glm::dvec3> velocities(count);
+    glm::dvec3 momentum(0.0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        velocities[i] = (after[i] - before[i]) * (0.5 / h);
+        if (static_cast<int>(i) != mSun)
+            momentum += velocities[i] * mScene.bodies[i].mass;
+    }
+    velocities[mSun] = -momentum / mScene.bodies[mSun].mass;
+
+    std::size_t particles = 0;
+    for (auto population : mPopulation)
+        particles += population;
+    mGravity->clear();
+    mGravity->reserve(count + particles);
+    for (std::size_t i = 0; i < count; i++)
+        mGravity->add(mScene.bodies[i].mass, positions[i], velocities[i]);
+
+    // Particles on circular orbits, uniform over each population's area, with
+    // their planes spread around its own
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (std::size_t p = 0; p < mPopulation.size(); p++)
+    {
+        auto const & population = mScene.populations[p];
+        std::normal_distribution<double> inclination(0.0, glm::radians(population.inclination));
+        glm::dvec3 center = positions[population.center];
+        glm::dvec3 drift = velocities[population.center];
+        double gravity = GaussianGravity * mScene.bodies[population.center].mass;
+        double mass = population.mass / std::max(mPopulation[p], 1);
+        for (int n = 0; n < mPopulation[p]; n++)
+        {
+            double radius = std::sqrt(glm::mix(population.inner * population.inner,
+                                               population.outer * population.outer, unit(random))) / AU;
+            double angle = glm::two_pi<double>() * unit(random);
+            double node = glm::two_pi<double>() * unit(random);
+            double speed = std::sqrt(gravity / radius);
+            glm::dvec3 position(radius * std::cos(angle), radius * std::sin(angle), 0.0);
+            glm::dvec3 velocity(-speed * std::sin(angle), speed * std::cos(angle), 0.0);
+            double tilt = glm::radians(population.tilt);
+            double incline = inclination(random);
+            position = rotateX(rotateZ(rotateX(position, incline), node), tilt);
+            velocity = rotateX(rotateZ(rotateX(velocity, incline), node), tilt);
+            mGravity->add(mass, center + position, drift + velocity);
+        }
+    }
+    mGravityEpoch = epoch;
+}
+
+void SolarSystem::gravitate(double epoch, std::vector<glm::vec3> & offsets, std::vector<glm::vec3> & particles)
+{
+    if (epoch < mGravityEpoch || epoch - mGravityEpoch > reseedSpan)
+        seedGravity(epoch);
+    while (mGravityEpoch + gravityStep <= epoch)
+    {
+        mGravity->step(gravityStep);
+        mGravityEpoch += gravityStep;
+    }
+
+    // Bodies relative to the body they orbit, or else to the Sun
+    std::size_t count = mOrbits.size();
+    offsets.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        int parent = mScene.bodies[i].parent >= 0 ? mScene.bodies[i].parent : mSun;
+        glm::dvec3 relative = mGravity->position(i) - mGravity->position(parent);
+        offsets[i] = toWorld(relative * AU, mOffsets[i]);
+    }
+
+    // Particles around the place their center is drawn at
+    std::size_t id = count;
+    particles.clear();
+    for (std::size_t p = 0; p < mPopulation.size(); p++)
+    {
+        auto const & population = mScene.populations[p];
+        glm::vec3 center(0.0f);
+        for (int body = population.center; body >= 0; body = mScene.bodies[body].parent)
+            center += offsets[body];
+        glm::dvec3 origin = mGravity->position(population.center);
+        for (int n = 0; n < mPopulation[p]; n++)
+            particles.push_back(center + toWorld((mGravity->position(id++) - origin) * AU, population.offset));
+    }
+}
+
+void SolarSystem::startSimulation(double ticksPerSecond)
+{
+    stopSimulation();
+    mTickLength = 1.0 / ticksPerSecond;
+    mSeek = -1.0;
+
+    // Both ticks of the first state are the present, so frames drawn before
+    // the first real tick stand still
+    Tick first;
+    first.time = 0.0;
+    first.epoch = mEpoch;
+    propagate(mEpoch, first.offsets, mParticles);
+    for (int i = 0; i < 3; i++)
+    {
+        mTicks.slot(i).previous = mTicks.slot(i).current = first;
+        mTicks.slot(i).particles = mParticles;
+    }
+    if (mCloud) mCloud->upload(mParticles);
+
+    mOrigin = std::chrono::steady_clock::now();
+    mRunning = true;
+    mSimulation = std::thread(&SolarSystem::simulate, this, first, ticksPerSecond);
+}
+
+void SolarSystem::stopSimulation()
+{
+    if (!mSimulation.joinable())
+        return;
+    mRunning = false;
+    mSimulation.join();
+}
+
+void SolarSystem::simulate(Tick last, double ticksPerSecond)
+{
+    // Tick k holds the state at k tick lengths after the origin and is
+    // published once the clock gets there; a late tick is published at once
+    for (long long k = 1; mRunning; k++)
+    {
+        Ticks & ticks = mTicks.back();
+        ticks.previous = last;
+        ticks.current.time = k * mTickLength;
+        double seek = mSeek.exchange(-1.0);
+        ticks.current.epoch = seek >= 0.0 ? seek : last.epoch + mTickLength * mTimeWarp;
+        propagate(ticks.current.epoch, ticks.current.offsets, ticks.particles);
+        last = ticks.current;
+
+        std::this_thread::sleep_until(mOrigin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double>(k / ticksPerSecond)));
+        mTicks.publish();
+    }
+}
+
+void SolarSystem::interpolate()
+{
+    Mirage::Profiler::GpuScope scope("interpolate");
+    bool fresh = mTicks.update();
+    Ticks const & ticks = mTicks.front();
+
+    // Draw one tick in the past, where both neighbouring ticks are known
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - mOrigin).count() - mTickLength;
+    double span = ticks.current.time - ticks.previous.time;
+    double alpha = span > 0.0 ? glm::clamp((now - ticks.previous.time) / span, 0.0, 1.0) : 1.0;
+    float weight = static_cast<float>(alpha);
+    for (std::size_t i = 0; i < mBodies.size(); i++)
+        mBodies.setOffset(i, glm::mix(ticks.previous.offsets[i], ticks.current.offsets[i], weight));
+    mEpoch = ticks.previous.epoch + (ticks.current.epoch - ticks.previous.epoch) * alpha;
+    mTime = static_cast<float>(ticks.previous.time + span * alpha);
+    mBodies.update(mTime);
+    if (fresh && mCloud) mCloud->upload(ticks.particles);
+}
+
+std::size_t SolarSystem::cpuBytes() const
+{
+    std::size_t bytes = 0;
+    for (auto const & model : mModels)
+        if (model) bytes += model->cpuBytes();
+    return bytes;
+}
+
+std::size_t SolarSystem::gpuBytes() const
+{
+    std::size_t bytes = mSphere->gpuBytes();
+    for (auto const & model : mModels)
+        if (model) bytes += model->gpuBytes();
+    for (auto const & surface : mSurfaces)
+        for (auto const & texture : surface)
+            bytes += texture.handle.bytes();
+    if (mVirtual)
+        bytes += mVirtual->gpuBytes();
+    return bytes;
+}
+
+void SolarSystem::draw(Camera & camera)
+{
+    // Every pass is profiled on its own, the mesh passes by program
+    Mirage::Profiler::GpuScope scope("draw");
+
+    // view/projection transformations, uploaded once for every program
+    CameraBlock block;
+    block.projection = glm::perspective(glm::radians(camera.Zoom),
+                                        (float)1200 / (float)800, nearPlane, farPlane);
+    block.view = camera.GetViewMatrix();
+    {
+        Mirage::Profiler::GpuScope pass("clear");
+
+        // Background Fill Color
+        glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, Mirage::Shader::CameraBlock, mCameraBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    }
+
+    Frustum frustum(block.projection * block.view);
+    {
+        Mirage::Profiler::Scope pass("cull");
+        cull(frustum);
+    }
+
+    // Pick the detail of every sphere from its radius on screen
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = block.projection[1][1] * viewport[3] * 0.5f;
+    {
+        Mirage::Profiler::GpuScope pass("detail");
+        selectLevels(camera.Position, pixelsPerUnit);
+        mTracks->update(camera.Position, pixelsPerUnit);
+        mCounters.trackSegments = mTracks->segments();
+        mCounters.trackUploads = mTracks->uploads();
+    }
+
+    // Bring in the tiles the last feedback asked for before they are drawn
+    if (mVirtual) {
+        Mirage::Profiler::GpuScope pass("tiles");
+        mVirtual->update();
+    }
+
+    // Queue every mesh draw of the frame, then issue them sorted by state
+    {
+        Mirage::Profiler::Scope pass("submit");
+        mQueue.begin(farPlane);
+        submitBodies(camera.Position);
+        if (mBelt) {
+            double turns = (mEpoch - J2000) / mScene.belt.period;
+            float angle = static_cast<float>(glm::two_pi<double>() * (turns - std::floor(turns)));
+            mBelt->submit(mQueue, frustum, mBodies.position(mSun), angle);
+            mCounters.rocksDrawn = mBelt->drawn();
+            mCounters.rocksCulled = mBelt->culled();
+        }
+    }
+    mQueue.execute();
+
+    {
+        Mirage::Profiler::GpuScope pass("skybox");
+        drawSkybox();
+    }
+    {
+        Mirage::Profiler::GpuScope pass("tracks");
+        mTracks->draw();
+    }
+    if (mCloud) {
+        Mirage::Profiler::GpuScope pass("particles");
+        mCloud->draw();
+    }
+    if (mVirtual) {
+        Mirage::Profiler::GpuScope pass("feedback");
+        drawFeedback();
+    }
+
+    // Textures that were not drawn are the first to go when over budget
+    Mirage::Profiler::Scope pass("textures");
+    Mirage::TextureCache::global().collect();
+}
+
+void SolarSystem::cull(Frustum const & frustum)
+{
+    // World bounding sphere of every body: the model's, carried by its matrix
+    std::size_t count = mBodies.size();
+    mBoundX.resize(count);
+    mBoundY.resize(count);
+    mBoundZ.resize(count);
+    mBoundRadius.resize(count);
+    mBounds.resize(count);
+    mVisible.assign(count, 0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        glm::mat4 const & model = mBodies.model(i);
+        Mirage::Sphere const & local = mModels[i] ? mModels[i]->bounds() : mSphere->bounds();
+        glm::vec3 center = glm::vec3(model * glm::vec4(local.center, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(model[0])),
+                      std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        mBoundX[i] = center.x;
+        mBoundY[i] = center.y;
+        mBoundZ[i] = center.z;
+        mBoundRadius[i] = local.radius * scale;
+        mBounds[i].center = center;
+        mBounds[i].radius = mBoundRadius[i];
+    }
+
+    if (count < bodyTreeThreshold)
+        frustum.visible(mBoundX.data(), mBoundY.data(), mBoundZ.data(), mBoundRadius.data(), count, mVisible.data());
+    else
+    {
+        // Bodies move a little each frame, so the tree is refitted and only
+        // rebuilt now and then, once orbits have stretched its boxes
+        if (mBodyTree.size() != count || ++mTreeAge >= bodyTreeRebuild)
+        {
+            mBodyTree.build(mBounds);
+            mTreeAge = 0;
+        }
+        else
+            mBodyTree.refit(mBounds);
+
+        mBodyRuns.clear();
+        mBodyTree.query(frustum, mBodyRuns);
+        for (auto const & run : mBodyRuns)
+            for (std::uint32_t i = run.first; i < run.first + run.count; i++)
+            {
+                std::uint32_t body = mBodyTree.order()[i];
+                mVisible[body] = frustum.visible(mBounds[body]);
+            }
+    }
+
+    mCounters.bodiesDrawn = 0;
+    for (std::size_t i = 0; i < count; i++)
+        mCounters.bodiesDrawn += mVisible[i];
+    mCounters.bodiesCulled = static_cast<int>(count) - mCounters.bodiesDrawn;
+}
+
+void SolarSystem::selectLevels(glm::vec3 const & eye, float pixelsPerUnit)
+{
+    // A sphere of radius r at distance d covers about r / d * pixelsPerUnit
+    // pixels; one around the eye gets the finest level
+    mCounters.sphereTriangles = 0;
+    for (std::size_t i = 0; i < mBodies.size(); i++)
+    {
+        if (mModels[i] || !mVisible[i])
+            continue;
+        float distance = glm::length(mBounds[i].center - eye);
+        float pixels = distance > mBounds[i].radius
+                     ? mBounds[i].radius / distance * pixelsPerUnit
+                     : std::numeric_limits<float>::max();
+        mLevels[i] = Icosphere::select(pixels, mLevels[i]);
+        mCounters.sphereTriangles += static_cast<int>(mSphere->triangles(mLevels[i]));
+    }
+}
+
+void SolarSystem::submitBodies(glm::vec3 const & eye)
+{
+    for (std::size_t i = 0; i < mBodies.size(); i++)
+    {
+        if (!mVisible[i])
+            continue;
+        bool sun = static_cast<int>(i) == mSun;
+        RenderQueue::Id program = sun ? mSunProgram : mPlanetProgram;
+        float depth = std::max(glm::length(mBounds[i].center - eye) - mBounds[i].radius, 0.0f);
+        glm::mat4 const & model = mBodies.model(i);
+        glm::mat3x4 const & normal = mBodies.normal(i);
+        if (!mModels[i])
+        {
+            RenderQueue::Id surface = program;
+            if (mVirtualMaps[mSurfaceOf[i]] >= 0)
+                surface = sun ? mVirtualSunProgram : mVirtualPlanetProgram;
+            mQueue.submit(surface, mSurfaceMaterials[mSurfaceOf[i]], mSphereMeshes[mLevels[i]], model, normal, depth);
+        }
+        for (auto const & part : mParts[i])
+            mQueue.submit(program, part.material, part.mesh, model, normal, depth);
+    }
+}
+
+void SolarSystem::drawFeedback()
+{
+    // The tiled spheres once more, small, each pixel naming the tile it reads
+    mVirtual->beginFeedback();
+    mFeedbackShader.activate();
+    Mirage::Mesh & sphere = mSphere->mesh();
+    glBindVertexArray(sphere.vertexArray());
+    mFeedbackShader.bind("positionScale", sphere.positionScale());
+    mFeedbackShader.bind("positionOffset", sphere.positionOffset());
+    for (std::size_t i = 0; i < mBodies.size(); i++)
+    {
+        if (mSurfaceOf[i] < 0 || mVirtualMaps[mSurfaceOf[i]] < 0 || !mVisible[i])
+            continue;
+        mFeedbackShader.bind("model", mBodies.model(i));
+        mVirtual->bindFeedback(mFeedbackShader, mVirtualMaps[mSurfaceOf[i]]);
+        sphere.drawElements(mSphere->firstIndex(mLevels[i]), mSphere->indexCount(mLevels[i]));
+    }
+    glBindVertexArray(0);
+    mVirtual->endFeedback();
+}
+
+void SolarSystem::drawSkybox()
+{
+    /* DRAW SKYBOX */
+    glDepthFunc(GL_LEQUAL);
+    mSkyboxShader.activate();
+    // skybox cube
+    glBindVertexArray(mSkyboxVAO);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, mCubemap);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    /* DRAW SKYBOX */
+}
+
+unsigned int loadCubemap(std::vector<std::string> faces, Mirage::AssetLoader & loader)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    // Decode each face on a worker and upload it into the texture on this thread
+    for (unsigned int i = 0; i < faces.size(); i++)
+    {
+        std::string face = faces[i];
+        loader.async([face, i, textureID, &loader] {
+            std::shared_ptr<DecodedImage> image(new DecodedImage(face));
+            loader.upload([face, i, textureID, image] {
+                if (!image->pixels) {
+                    std::cout << "Cubemap texture failed to load at path: " << face << std::endl;
+                    return;
+                }
+                glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                             0, GL_RGB, image->width, image->height, 0, GL_RGB, GL_UNSIGNED_BYTE, image->pixels);
+            });
+        });
+    }
+    return textureID;
+}
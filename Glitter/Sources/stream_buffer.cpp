@@ -0,0 +1,105 @@
+// Local Headers
+#include "stream_buffer.hpp"
+
+// Smallest region allocated, so that small scenes never regrow
+static const std::size_t minimumRegion = 64 * 1024;
+
+StreamBuffer::StreamBuffer(GLenum target)
+        : mTarget(target)
+        , mRegionBytes(0)
+        , mRegion(0)
+        , mMapped(nullptr)
+{
+    for (auto & fence : mFences)
+        fence = nullptr;
+    allocate(minimumRegion);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (auto fence : mFences)
+        if (fence) glDeleteSync(fence);
+    if (mMapped)
+    {
+        glBindBuffer(mTarget, mBuffer.get());
+        glUnmapBuffer(mTarget);
+    }
+}
+
+bool StreamBuffer::persistent()
+{
+    return GLAD_GL_VERSION_4_4 != 0;
+}
+
+void StreamBuffer::allocate(std::size_t regionBytes)
+{
+    // The old buffer lives on in the GL until the draws reading it are done
+    for (auto & fence : mFences)
+    {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (mMapped)
+    {
+        glBindBuffer(mTarget, mBuffer.get());
+        glUnmapBuffer(mTarget);
+        mMapped = nullptr;
+    }
+
+    mRegionBytes = regionBytes;
+    mRegion = 0;
+    mBuffer = Mirage::Buffer::create();
+    glBindBuffer(mTarget, mBuffer.get());
+    if (persistent())
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(mTarget, size(), nullptr, flags);
+        mMapped = static_cast<unsigned char *>(glMapBufferRange(mTarget, 0, size(), flags));
+        mStaging.clear();
+    }
+    else
+    {
+        glBufferData(mTarget, size(), nullptr, GL_STREAM_DRAW);
+        mStaging.resize(mRegionBytes);
+    }
+    glBindBuffer(mTarget, 0);
+}
+
+void * StreamBuffer::begin(std::size_t bytes)
+{
+    if (bytes > mRegionBytes)
+    {
+        std::size_t grown = mRegionBytes;
+        while (grown < bytes)
+            grown *= 2;
+        allocate(grown);
+    }
+    else
+        mRegion = (mRegion + 1) % Regions;
+
+    // Wait until the GPU has read what was written here Regions frames ago
+    GLsync & fence = mFences[mRegion];
+    if (fence)
+    {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            continue;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return mMapped ? mMapped + offset() : mStaging.data();
+}
+
+void StreamBuffer::flush(std::size_t bytes)
+{
+    if (mMapped || bytes == 0)
+        return;
+    glBindBuffer(mTarget, mBuffer.get());
+    glBufferSubData(mTarget, offset(), bytes, mStaging.data());
+    glBindBuffer(mTarget, 0);
+}
+
+void StreamBuffer::end()
+{
+    if (mMapped)
+        mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,336 @@
+// Local Headers
+#include "symplectic.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define SYMPLECTIC_AVX2
+#include <immintrin.h>
+#endif
+
+static const double pi = 3.14159265358979323846;
+
+// Newton iterations on the change of eccentric anomaly stop below this, in
+// radians; a body that has not converged by then, or is unbound, takes
+// fallbackSteps leapfrog steps about the central mass instead.
+static const double tolerance = 1e-14;
+static const int    maxIterations = 32;
+static const int    fallbackSteps = 16;
+
+// Moves a body along its Kepler orbit about a mass of parameter mu by the
+// f and g functions of the change in eccentric anomaly (Danby). Returns false,
+// leaving the body untouched, for orbits that are not bound ellipses.
+static bool keplerDrift(double mu, double dt, double & x, double & y, double & z,
+                        double & vx, double & vy, double & vz)
+{
+    double r0 = std::sqrt(x * x + y * y + z * z);
+    double v2 = vx * vx + vy * vy + vz * vz;
+    double u = x * vx + y * vy + z * vz;
+    double alpha = 2.0 / r0 - v2 / mu;
+    if (!(alpha > 0.0))
+        return false;
+
+    double a = 1.0 / alpha;
+    double n = std::sqrt(mu * alpha * alpha * alpha);
+    double ec = 1.0 - r0 * alpha;
+    double es = u / (n * a * a);
+
+    // Whole turns change nothing, so only the rest of the mean motion is solved
+    double dm = n * dt;
+    dm -= 2.0 * pi * std::floor((dm + pi) / (2.0 * pi));
+    double delta = dm;
+    double s = 0.0, c = 1.0, fp = 1.0;
+    int iteration = 0;
+    for (; iteration < maxIterations; iteration++)
+    {
+        s = std::sin(delta);
+        c = std::cos(delta);
+        fp = 1.0 - ec * c + es * s;
+        double step = (delta - ec * s + es * (1.0 - c) - dm) / fp;
+        delta -= step;
+        if (std::abs(step) < tolerance)
+            break;
+    }
+    if (iteration == maxIterations)
+        return false;
+    s = std::sin(delta);
+    c = std::cos(delta);
+    fp = 1.0 - ec * c + es * s;
+
+    double f = a / r0 * (c - 1.0) + 1.0;
+    double g = dm / n + (s - delta) / n;
+    double fdot = -a / (r0 * fp) * n * s;
+    double gdot = (c - 1.0) / fp + 1.0;
+    double px = x, py = y, pz = z;
+    x = f * px + g * vx;
+    y = f * py + g * vy;
+    z = f * pz + g * vz;
+    vx = fdot * px + gdot * vx;
+    vy = fdot * py + gdot * vy;
+    vz = fdot * pz + gdot * vz;
+    return true;
+}
+
+// The same drift for any orbit, approximated by leapfrog steps.
+static void centralLeapfrog(double mu, double dt, double & x, double & y, double & z,
+                            double & vx, double & vy, double & vz)
+{
+    double h = dt / fallbackSteps;
+    for (int k = 0; k < fallbackSteps; k++)
+    {
+        x += vx * h * 0.5;
+        y += vy * h * 0.5;
+        z += vz * h * 0.5;
+        double r2 = x * x + y * y + z * z;
+        double s = mu / (r2 * std::sqrt(r2)) * h;
+        vx -= s * x;
+        vy -= s * y;
+        vz -= s * z;
+        x += vx * h * 0.5;
+        y += vy * h * 0.5;
+        z += vz * h * 0.5;
+    }
+}
+
+SymplecticIntegrator::SymplecticIntegrator(double centralMass)
+        : mCentralMass(centralMass)
+        , mBarycentric(false)
+{
+}
+
+std::size_t SymplecticIntegrator::add(double mass, glm::dvec3 const & position, glm::dvec3 const & velocity)
+{
+    // Bodies are added with heliocentric velocities, which do not depend on
+    // what else is there; barycentric ones are derived again before stepping
+    if (mBarycentric)
+    {
+        glm::dvec3 central = centralVelocity();
+        for (std::size_t i = 0; i < size(); i++)
+        {
+            mVX[i] -= central.x;
+            mVY[i] -= central.y;
+            mVZ[i] -= central.z;
+        }
+        mBarycentric = false;
+    }
+
+    std::size_t index = size();
+    mX.push_back(position.x);
+    mY.push_back(position.y);
+    mZ.push_back(position.z);
+    mVX.push_back(velocity.x);
+    mVY.push_back(velocity.y);
+    mVZ.push_back(velocity.z);
+    mMass.push_back(mass);
+    if (mass > 0.0)
+        mMassive.push_back(index);
+    return index;
+}
+
+void SymplecticIntegrator::barycentric()
+{
+    if (mBarycentric)
+        return;
+
+    // The central mass moves so that the total momentum is zero
+    double total = mCentralMass;
+    glm::dvec3 momentum(0.0);
+    for (auto i : mMassive)
+    {
+        total += mMass[i];
+        momentum += glm::dvec3(mVX[i], mVY[i], mVZ[i]) * mMass[i];
+    }
+    glm::dvec3 central = -momentum / total;
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        mVX[i] += central.x;
+        mVY[i] += central.y;
+        mVZ[i] += central.z;
+    }
+    mBarycentric = true;
+}
+
+glm::dvec3 SymplecticIntegrator::centralVelocity() const
+{
+    glm::dvec3 momentum(0.0);
+    for (auto i : mMassive)
+        momentum += glm::dvec3(mVX[i], mVY[i], mVZ[i]) * mMass[i];
+    return -momentum / mCentralMass;
+}
+
+glm::dvec3 SymplecticIntegrator::position(std::size_t i) const
+{
+    return glm::dvec3(mX[i], mY[i], mZ[i]);
+}
+
+glm::dvec3 SymplecticIntegrator::velocity(std::size_t i) const
+{
+    glm::dvec3 v(mVX[i], mVY[i], mVZ[i]);
+    return mBarycentric ? v - centralVelocity() : v;
+}
+
+bool SymplecticIntegrator::vectorized()
+{
+#if defined(SYMPLECTIC_AVX2)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SymplecticIntegrator::step(double dt, Method method)
+{
+    barycentric();
+    if (method == VelocityVerlet)
+    {
+        // Kinetic energy depends on velocities only and potential energy on
+        // positions only, so alternating the two is symplectic
+        gather(true);
+        kick(dt * 0.5);
+        drift(dt);
+        gather(true);
+        kick(dt * 0.5);
+    }
+    else
+    {
+        gather(false);
+        kick(dt * 0.5);
+        jump(dt * 0.5);
+        kepler(dt);
+        jump(dt * 0.5);
+        gather(false);
+        kick(dt * 0.5);
+    }
+}
+
+void SymplecticIntegrator::gather(bool central)
+{
+    mPX.clear();
+    mPY.clear();
+    mPZ.clear();
+    mPGM.clear();
+    if (central)
+    {
+        mPX.push_back(0.0);
+        mPY.push_back(0.0);
+        mPZ.push_back(0.0);
+        mPGM.push_back(GaussianGravity * mCentralMass);
+    }
+    for (auto i : mMassive)
+    {
+        mPX.push_back(mX[i]);
+        mPY.push_back(mY[i]);
+        mPZ.push_back(mZ[i]);
+        mPGM.push_back(GaussianGravity * mMass[i]);
+    }
+}
+
+void SymplecticIntegrator::kick(double dt)
+{
+    // Every body is pulled by every gathered one except any at its very
+    // position, which is the body itself
+    std::size_t count = size();
+    std::size_t pulls = mPGM.size();
+    std::size_t i = 0;
+#if defined(SYMPLECTIC_AVX2)
+    __m256d zero = _mm256_setzero_pd();
+    __m256d step = _mm256_set1_pd(dt);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d x = _mm256_loadu_pd(&mX[i]);
+        __m256d y = _mm256_loadu_pd(&mY[i]);
+        __m256d z = _mm256_loadu_pd(&mZ[i]);
+        __m256d ax = zero, ay = zero, az = zero;
+        for (std::size_t j = 0; j < pulls; j++)
+        {
+            __m256d dx = _mm256_sub_pd(_mm256_set1_pd(mPX[j]), x);
+            __m256d dy = _mm256_sub_pd(_mm256_set1_pd(mPY[j]), y);
+            __m256d dz = _mm256_sub_pd(_mm256_set1_pd(mPZ[j]), z);
+            __m256d r2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+            __m256d s = _mm256_div_pd(_mm256_set1_pd(mPGM[j]), _mm256_mul_pd(r2, _mm256_sqrt_pd(r2)));
+            s = _mm256_and_pd(s, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+            ax = _mm256_add_pd(ax, _mm256_mul_pd(s, dx));
+            ay = _mm256_add_pd(ay, _mm256_mul_pd(s, dy));
+            az = _mm256_add_pd(az, _mm256_mul_pd(s, dz));
+        }
+        _mm256_storeu_pd(&mVX[i], _mm256_add_pd(_mm256_loadu_pd(&mVX[i]), _mm256_mul_pd(ax, step)));
+        _mm256_storeu_pd(&mVY[i], _mm256_add_pd(_mm256_loadu_pd(&mVY[i]), _mm256_mul_pd(ay, step)));
+        _mm256_storeu_pd(&mVZ[i], _mm256_add_pd(_mm256_loadu_pd(&mVZ[i]), _mm256_mul_pd(az, step)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        for (std::size_t j = 0; j < pulls; j++)
+        {
+            double dx = mPX[j] - mX[i], dy = mPY[j] - mY[i], dz = mPZ[j] - mZ[i];
+            double r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 <= 0.0)
+                continue;
+            double s = mPGM[j] / (r2 * std::sqrt(r2));
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        mVX[i] += ax * dt;
+        mVY[i] += ay * dt;
+        mVZ[i] += az * dt;
+    }
+}
+
+void SymplecticIntegrator::drift(double dt)
+{
+    // Heliocentric positions move with the body's velocity less the central
+    // mass's, which is the massive bodies' momentum over the central mass
+    glm::dvec3 central = centralVelocity();
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        mX[i] += (mVX[i] - central.x) * dt;
+        mY[i] += (mVY[i] - central.y) * dt;
+        mZ[i] += (mVZ[i] - central.z) * dt;
+    }
+}
+
+void SymplecticIntegrator::jump(double dt)
+{
+    glm::dvec3 central = centralVelocity();
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        mX[i] -= central.x * dt;
+        mY[i] -= central.y * dt;
+        mZ[i] -= central.z * dt;
+    }
+}
+
+void SymplecticIntegrator::kepler(double dt)
+{
+    double mu = GaussianGravity * mCentralMass;
+    for (std::size_t i = 0; i < size(); i++)
+        if (!keplerDrift(mu, dt, mX[i], mY[i], mZ[i], mVX[i], mVY[i], mVZ[i]))
+            centralLeapfrog(mu, dt, mX[i], mY[i], mZ[i], mVX[i], mVY[i], mVZ[i]);
+}
+
+double SymplecticIntegrator::energy()
+{
+    barycentric();
+    glm::dvec3 momentum(0.0);
+    double kinetic = 0.0, potential = 0.0;
+    for (std::size_t k = 0; k < mMassive.size(); k++)
+    {
+        std::size_t i = mMassive[k];
+        glm::dvec3 v(mVX[i], mVY[i], mVZ[i]);
+        momentum += v * mMass[i];
+        kinetic += 0.5 * mMass[i] * glm::dot(v, v);
+        potential -= GaussianGravity * mCentralMass * mMass[i] / glm::length(position(i));
+        for (std::size_t l = k + 1; l < mMassive.size(); l++)
+        {
+            std::size_t j = mMassive[l];
+            potential -= GaussianGravity * mMass[i] * mMass[j] / glm::length(position(i) - position(j));
+        }
+    }
+
+    // The central mass carries the opposite of the bodies' momentum
+    return kinetic + glm::dot(momentum, momentum) / (2.0 * mCentralMass) + potential;
+}
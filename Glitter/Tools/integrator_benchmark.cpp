@@ -0,0 +1,163 @@
+// Local Headers
+#include "symplectic.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Steps the integrator on systems of growing size with both of its maps and
+// reports how fast it went and how far the energy wandered. The Sun counts
+// as one body; the nine planets from Mercury to Pluto come next, on their
+// J2000 semi-major axes, eccentricities and inclinations, and any further
+// bodies are main-belt asteroids. Asteroids carry a token mass while the
+// system is small enough to sum every pair, and none beyond that, so the
+// largest systems measure the planets' energy while timing every body.
+
+static const double pi = 3.14159265358979323846;
+
+static const struct
+{
+    double a;           // astronomical units
+    double e;
+    double inclination; // degrees
+    double mass;        // solar masses
+} planets[] = {
+    {  0.38709927, 0.20563593,  7.00497902, 1.6601e-7 },
+    {  0.72333566, 0.00677672,  3.39467605, 2.4478e-6 },
+    {  1.00000261, 0.01671123,  0.00001531, 3.0404e-6 },
+    {  1.52371034, 0.09339410,  1.84969142, 3.2272e-7 },
+    {  5.20288700, 0.04838624,  1.30439695, 9.5479e-4 },
+    {  9.53667594, 0.05386179,  2.48599187, 2.8589e-4 },
+    { 19.18916464, 0.04725744,  0.77263783, 4.3662e-5 },
+    { 30.06992276, 0.00859048,  1.77004347, 5.1514e-5 },
+    { 39.48211675, 0.24882730, 17.14001206, 6.5500e-9 },
+};
+
+// Asteroids keep a mass up to this many bodies in all
+static const std::size_t massiveLimit = 20000;
+static const double asteroidMass = 1e-12;
+
+// Position and velocity on an orbit about the Sun, at a mean anomaly, with
+// the node and the argument of periapsis given in radians.
+static void orbitState(double a, double e, double inclination, double node, double argument, double M,
+                       glm::dvec3 & position, glm::dvec3 & velocity)
+{
+    double E = M;
+    for (int k = 0; k < 32; k++)
+        E -= (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+    double n = std::sqrt(GaussianGravity / (a * a * a));
+    double b = a * std::sqrt(1.0 - e * e);
+    double rate = n / (1.0 - e * std::cos(E));
+    double xp = a * (std::cos(E) - e), yp = b * std::sin(E);
+    double vxp = -a * std::sin(E) * rate, vyp = b * std::cos(E) * rate;
+
+    double cw = std::cos(argument), sw = std::sin(argument);
+    double cn = std::cos(node),     sn = std::sin(node);
+    double ci = std::cos(inclination), si = std::sin(inclination);
+    glm::dvec3 p(cw * cn - sw * sn * ci, cw * sn + sw * cn * ci, sw * si);
+    glm::dvec3 q(-sw * cn - cw * sn * ci, -sw * sn + cw * cn * ci, cw * si);
+    position = p * xp + q * yp;
+    velocity = p * vxp + q * vyp;
+}
+
+static void populate(SymplecticIntegrator & system, std::size_t bodies, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    glm::dvec3 position, velocity;
+    for (std::size_t i = 0; i + 1 < bodies; i++)
+    {
+        double a, e, inclination, mass;
+        if (i < sizeof(planets) / sizeof(planets[0]))
+        {
+            a = planets[i].a;
+            e = planets[i].e;
+            inclination = planets[i].inclination * pi / 180.0;
+            mass = planets[i].mass;
+        }
+        else
+        {
+            a = 2.1 + 1.2 * unit(random);
+            e = 0.2 * unit(random);
+            inclination = 10.0 * pi / 180.0 * unit(random);
+            mass = bodies <= massiveLimit ? asteroidMass : 0.0;
+        }
+        orbitState(a, e, inclination, 2.0 * pi * unit(random), 2.0 * pi * unit(random), 2.0 * pi * unit(random),
+                   position, velocity);
+        system.add(mass, position, velocity);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    // Parse Command Line Options
+    std::vector<std::size_t> sizes;
+    double dt = 1.0;
+    long long steps = 1000000;
+    double seconds = 5.0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bodies" && i + 1 < argc)
+            sizes.push_back(static_cast<std::size_t>(std::max(1, std::atoi(argv[++i]))));
+        else if (arg == "--dt" && i + 1 < argc)
+            dt = std::atof(argv[++i]);
+        else if (arg == "--steps" && i + 1 < argc)
+            steps = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc)
+            seconds = std::atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--bodies N]... [--dt days] [--steps N] [--seconds limit]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = { 10, 10000, 1000000 };
+
+    fprintf(stderr, "Kicks: %s; step %.3g days, at most %lld steps or %.3g s per run\n",
+            SymplecticIntegrator::vectorized() ? "AVX2" : "scalar", dt, steps, seconds);
+    printf("%-8s %-8s %-16s %10s %12s %14s %12s %12s\n",
+           "bodies", "massive", "method", "steps", "steps/s", "body-steps/s", "max|dE/E|", "dE/E");
+
+    const SymplecticIntegrator::Method methods[] = { SymplecticIntegrator::VelocityVerlet, SymplecticIntegrator::WisdomHolman };
+    const char * names[] = { "velocity-verlet", "wisdom-holman" };
+    for (auto bodies : sizes)
+        for (int m = 0; m < 2; m++)
+        {
+            SymplecticIntegrator system;
+            populate(system, bodies, 1);
+
+            // Energy is checked between batches of steps, small enough that
+            // the time limit is kept, and left out of the timing
+            std::size_t pairs = std::max<std::size_t>(system.size() * (system.massive() + 1), 1);
+            long long batch = std::min<long long>(std::max<long long>(1000000 / pairs, 1), 1000);
+            double initial = system.energy();
+            double worst = 0.0, drift = 0.0, elapsed = 0.0;
+            long long done = 0;
+            while (done < steps && elapsed < seconds)
+            {
+                long long count = std::min(batch, steps - done);
+                auto start = std::chrono::steady_clock::now();
+                for (long long k = 0; k < count; k++)
+                    system.step(dt, methods[m]);
+                elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                done += count;
+
+                drift = (system.energy() - initial) / std::abs(initial);
+                worst = std::max(worst, std::abs(drift));
+            }
+
+            double rate = done / std::max(elapsed, 1e-9);
+            printf("%-8zu %-8zu %-16s %10lld %12.1f %14.3e %12.3e %12.3e\n",
+                   bodies, system.massive() + 1, names[m], done, rate, rate * system.size(), worst, drift);
+            fflush(stdout);
+        }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// Local Headers
+#include "nbody.hpp"
+#include "scene_file.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+// Writes synthetic scenes for scaling experiments: a star, planets scattered
+// over the distances of the real ones, the same number of moons around each
+// planet, and a belt with rocks to draw and particles for the gravity mode.
+// Every body wraps one of the maps under Models/, so a scene of any size
+// loads a handful of textures. The same options and seed always give the
+// same scene; Glitter --scene file.scene --write-ephemeris file.eph then fits
+// its orbits without opening a window.
+
+static const double pi = 3.14159265358979323846;
+
+static const char * const starMap = "Models/sun/8k_sun.jpg";
+static const char * const moonMap = "Models/Moon/lroc_color_poles_1k.jpg";
+static const char * const planetMaps[] = {
+    "Models/Jupiter/8k_jupiter.jpg",
+    "Models/Neptune/Solarsystemscope_texture_2k_neptune.jpg",
+    "Models/Uranus/Solarsystemscope_texture_2k_uranus.jpg",
+    "Models/Venus/4k_venus_atmosphere.jpg",
+};
+
+// Offset of every planet and of the belt, as in the default scene
+static const float planetOffset = 150.0f;
+
+// Mean motion in degrees per century of a body at a distance in kilometers
+// around a mass in solar masses.
+static double meanMotion(double distance, double mass)
+{
+    double a = distance / AU;
+    return std::sqrt(GaussianGravity * mass / (a * a * a)) * 180.0 / pi * 36525.0;
+}
+
+int main(int argc, char * argv[])
+{
+    // Parse Command Line Options
+    int planets = 8;
+    int moons = 0;
+    int rocks = 0;
+    int particles = 0;
+    unsigned int seed = 1;
+    std::string path;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--planets" && i + 1 < argc)
+            planets = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--moons" && i + 1 < argc)
+            moons = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--rocks" && i + 1 < argc)
+            rocks = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--particles" && i + 1 < argc)
+            particles = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (path.empty() && arg[0] != '-')
+            path = arg;
+        else
+        {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty())
+    {
+        fprintf(stderr, "Usage: %s [--planets N] [--moons N per planet] [--rocks N] [--particles N] [--seed N] file.scene\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto between = [&](double low, double high) { return low + (high - low) * unit(random); };
+    auto spread = [&](double low, double high) { return low * std::pow(high / low, unit(random)); };
+
+    SceneFile scene;
+    scene.bodies.reserve(1 + std::size_t(planets) * (1 + moons));
+    SceneFile::Body star;
+    star.name = "Star";
+    star.surface = starMap;
+    star.mass = 1.0;
+    star.spin = 5.875f;
+    scene.bodies.push_back(star);
+
+    // Planets from a little inside Mercury to a little beyond Neptune, evenly
+    // in the logarithm of their distance, each followed by its moons
+    for (int p = 0; p < planets; p++)
+    {
+        SceneFile::Body planet;
+        planet.name = "Planet" + std::to_string(p + 1);
+        planet.surface = planetMaps[p % (sizeof(planetMaps) / sizeof(planetMaps[0]))];
+        planet.mass = spread(1e-7, 1e-3);
+        OrbitalElements & e = planet.elements;
+        e.semiMajorAxis = spread(0.3, 40.0) * AU;
+        e.eccentricity = between(0.0, 0.1);
+        e.inclination = between(0.0, 5.0);
+        e.meanLongitude = between(0.0, 360.0);
+        e.perihelionLongitude = between(0.0, 360.0);
+        e.ascendingNode = between(0.0, 360.0);
+        e.meanLongitudeRate = meanMotion(e.semiMajorAxis, 1.0 + planet.mass);
+        planet.offset = planetOffset;
+        planet.spin = static_cast<float>(between(100.0, 450.0));
+        planet.tilt = static_cast<float>(between(-30.0, 30.0));
+        planet.scale = 0.1f;
+        int parent = static_cast<int>(scene.bodies.size());
+        scene.bodies.push_back(planet);
+
+        for (int m = 0; m < moons; m++)
+        {
+            SceneFile::Body moon;
+            moon.name = planet.name + "." + std::to_string(m + 1);
+            moon.surface = moonMap;
+            moon.parent = parent;
+            moon.mass = spread(1e-10, 1e-8);
+            OrbitalElements & orbit = moon.elements;
+            orbit.semiMajorAxis = spread(2e5, 3e6);
+            orbit.eccentricity = between(0.0, 0.05);
+            orbit.inclination = between(0.0, 10.0);
+            orbit.meanLongitude = between(0.0, 360.0);
+            orbit.perihelionLongitude = between(0.0, 360.0);
+            orbit.ascendingNode = between(0.0, 360.0);
+            orbit.meanLongitudeRate = meanMotion(orbit.semiMajorAxis, planet.mass + moon.mass);
+            moon.offset = static_cast<float>(between(12.0, 40.0));
+            moon.spin = static_cast<float>(between(0.2, 5.0));
+            moon.tilt = planet.tilt;
+            moon.scale = 0.02f;
+            scene.bodies.push_back(moon);
+        }
+    }
+
+    // The main belt of the default scene, with the rocks and particles asked for
+    SceneFile::Belt & belt = scene.belt;
+    belt.inner = 2.1 * AU;
+    belt.outer = 3.3 * AU;
+    belt.period = 1680.0;
+    belt.offset = planetOffset;
+    belt.rocks = rocks;
+
+    SceneFile::Population population;
+    population.name = "belt";
+    population.inner = belt.inner;
+    population.outer = belt.outer;
+    population.inclination = 8.0;
+    population.mass = 1.5e-9;
+    population.offset = planetOffset;
+    population.particles = particles;
+    scene.populations.push_back(population);
+
+    if (!scene.save(path))
+    {
+        fprintf(stderr, "Failed to Write Scene %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Scene %s: %zu bodies, %d planets with %d moons each; %d rocks, %d particles\n",
+            path.c_str(), scene.bodies.size(), planets, moons, rocks, particles);
+    return EXIT_SUCCESS;
+}
@@ -74,6 +74,15 @@ void Camera::ProcessMouseScroll(float yoffset) {
         Zoom = 45.0f;
 }
 
+// Turns the camera towards a point, recomputing the Euler Angles from the
+// current position. Used to script camera paths without mouse input.
+void Camera::LookAt(glm::vec3 target) {
+    glm::vec3 direction = glm::normalize(target - Position);
+    Yaw = glm::degrees(std::atan2(direction.z, direction.x));
+    Pitch = glm::degrees(std::asin(direction.y));
+    updateCameraVectors();
+}
+
 // Calculates the front vector from the Camera's (updated) Euler Angles
 void Camera::updateCameraVectors() {
     // Calculate the new Front vector
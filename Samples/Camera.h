@@ -61,6 +61,10 @@ public:
     // input on the vertical wheel-axis
     void ProcessMouseScroll(float yoffset);
 
+    // Turns the camera towards a point, recomputing the Euler Angles from the
+    // current position. Used to script camera paths without mouse input.
+    void LookAt(glm::vec3 target);
+
 private:
     // Calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors();
@@ -1,45 +1,144 @@
 #include "Model.h"
 
+// starts loading on the loader's workers: the file is read and every distinct texture decoded in parallel,
+// while textures and meshes are created on the context thread, textures first.
+Model::Model(string const &path, Mirage::AssetLoader &loader, Mirage::VertexFormat format, Mirage::CpuCopy copy, bool gamma)
+    : gammaCorrection(gamma), format(format), cpuCopy(copy)
+{
+    directory = path.substr(0, path.find_last_of('/'));
+    loader.async([this, path, &loader] {
+        std::shared_ptr<Staged> staged(new Staged);
+        if (!stage(path, *staged))
+            return;
+
+        // each texture path only once, as loadTexture would
+        vector<pair<string, string>> unique;
+        for (auto const & mesh : staged->meshes)
+        for (auto const & texture : mesh.textures)
+            if (std::find_if(unique.begin(), unique.end(), [&texture](pair<string, string> const & other) {
+                    return other.second == texture.second; }) == unique.end())
+                unique.push_back(texture);
+
+        auto build = [this, staged] { createMeshes(*staged); };
+        if (unique.empty()) {
+            loader.upload(build);
+            return;
+        }
+
+        // whichever decode finishes last queues the meshes behind every texture upload
+        std::shared_ptr<std::atomic<std::size_t>> remaining(new std::atomic<std::size_t>(unique.size()));
+        for (auto const & texture : unique)
+            loader.async([this, texture, remaining, build, &loader] {
+                // textures another model already loaded are neither decoded nor uploaded again
+                string file = directory + '/' + texture.second;
+                if (!Mirage::TextureCache::global().contains(file)) {
+                    Mirage::Profiler::Scope scope("decode texture");
+                    std::shared_ptr<Mirage::MipChain> mips(new Mirage::MipChain(file));
+                    loader.upload([this, texture, mips] {
+                        loadTexture(texture.second, texture.first, mips);
+                    });
+                }
+                if (--*remaining == 0)
+                    loader.upload(build);
+            });
+    });
+}
+
 // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
 void Model::loadModel(const string &path) {
+    Mirage::Profiler::Scope scope("load model");
+
+    // retrieve the directory path of the filepath
+    directory = path.substr(0, path.find_last_of('/'));
+
+    Staged staged;
+    if (stage(path, staged))
+        createMeshes(staged);
+}
+
+// reads the vertex and index arrays and the texture names of every mesh, from the mesh cache when it is
+// current or else through ASSIMP, refreshing the cache. Makes no GL calls, so it can run on any thread.
+bool Model::stage(const string &path, Staged &staged) {
+    Mirage::Profiler::Scope scope("read model");
+
+    // reuse the arrays of a previous import when the file and flags are unchanged
+    const unsigned int flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+    staged.cache.reset(new Mirage::MeshCache(path, flags));
+    if (staged.cache->load())
+    {
+        staged.meshes = staged.cache->meshes();
+        return true;
+    }
+
     // read file via ASSIMP
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    const aiScene* scene = importer.ReadFile(path, flags);
     // check for errors
     if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
     {
         cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-        return;
+        return false;
     }
-    // retrieve the directory path of the filepath
-    directory = path.substr(0, path.find_last_of('/'));
 
-    // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene);
+    // process ASSIMP's root node recursively, then point the records at the finished arrays
+    processNode(scene->mRootNode, scene, staged);
+    for (std::size_t i = 0; i < staged.meshes.size(); i++)
+    {
+        staged.meshes[i].vertices    = staged.vertices[i].data();
+        staged.meshes[i].vertexCount = static_cast<std::uint32_t>(staged.vertices[i].size());
+        staged.meshes[i].indices     = staged.indices[i].data();
+        staged.meshes[i].indexCount  = static_cast<std::uint32_t>(staged.indices[i].size());
+    }
+    if (!staged.cache->store(staged.meshes))
+        cout << "Failed to write mesh cache " << staged.cache->path() << endl;
+    return true;
+}
+
+// creates the GL buffers of every staged mesh, loading any texture that is not loaded yet.
+void Model::createMeshes(Staged const &staged) {
+    Mirage::Profiler::Scope scope("create meshes");
+
+    // build every mesh in place; a mesh is never copied, and its arrays are only kept when asked for
+    meshes.reserve(meshes.size() + staged.meshes.size());
+    for (auto const & staging : staged.meshes)
+    {
+        vector<Mirage::Texture> textures;
+        for (auto const & texture : staging.textures)
+            textures.push_back(loadTexture(texture.second, texture.first));
+        meshes.emplace_back(staging.vertices, staging.vertexCount,
+                            staging.indices, staging.indexCount, std::move(textures), format, cpuCopy);
+
+        // grow the model's bounding sphere, computed from the vertices while they are at hand
+        Mirage::Mesh const & mesh = meshes.back();
+        boundingSphere = meshes.size() == 1 ? mesh.bounds() : Mirage::enclose(boundingSphere, mesh.bounds());
+    }
 }
 
 // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-void Model::processNode(aiNode *node, const aiScene *scene) {
+void Model::processNode(aiNode *node, const aiScene *scene, Staged &staged) {
     // process each mesh located at the current node
     for(unsigned int i = 0; i < node->mNumMeshes; i++)
     {
         // the node object only contains indices to index the actual objects in the scene.
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        processMesh(mesh, scene, staged);
     }
     // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
     for(unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, staged);
     }
 }
 
-Mirage::Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+void Model::processMesh(aiMesh *mesh, const aiScene *scene, Staged &staged) {
     // data to fill
-    vector<Mirage::Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Mirage::Texture> textures;
+    staged.vertices.push_back(vector<Mirage::Vertex>());
+    staged.indices.push_back(vector<unsigned int>());
+    staged.meshes.push_back(Mirage::CachedMesh());
+    vector<Mirage::Vertex> &vertices = staged.vertices.back();
+    vector<unsigned int> &indices = staged.indices.back();
+    vector<pair<string, string>> &textures = staged.meshes.back().textures;
 
     // walk through each of the mesh's vertices
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -102,87 +201,67 @@ Mirage::Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     // normal: texture_normalN
 
     // 1. diffuse maps
-    vector<Mirage::Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+    materialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
     // 2. specular maps
-    vector<Mirage::Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    materialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
     // 3. normal maps
-    std::vector<Mirage::Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+    materialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
     // 4. height maps
-    std::vector<Mirage::Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-    textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-    // return a mesh object created from the extracted mesh data
-    return Mirage::Mesh(vertices, indices, textures);
+    materialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
 }
 
-vector<Mirage::Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName) {
-    vector<Mirage::Texture> textures;
+// appends the type and path of every texture of the given type in a material.
+void Model::materialTextures(aiMaterial *mat, aiTextureType type, string typeName, vector<pair<string, string>> &textures) {
     for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
-        // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-        bool skip = false;
-        for(unsigned int j = 0; j < textures_loaded.size(); j++)
-        {
-            if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                break;
-            }
-        }
-        if(!skip)
-        {   // if texture hasn't been loaded already, load it
-            Mirage::Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-        }
+        textures.push_back(std::make_pair(typeName, string(str.C_Str())));
     }
-    return textures;
+}
+
+Mirage::Texture Model::loadTexture(string const &path, string const &typeName, std::shared_ptr<Mirage::MipChain> const &mips) {
+    // check if this model uses the texture already; other models' textures come from the cache
+    auto found = textures_loaded.find(path);
+    if (found != textures_loaded.end())
+        return found->second;
+
+    Mirage::TextureCache &cache = Mirage::TextureCache::global();
+    string file = directory + '/' + path;
+    Mirage::Texture texture;
+    texture.handle = mips ? cache.acquire(file, mips) : cache.acquire(file);
+    texture.type = typeName;
+    texture.path = path;
+    textures_loaded.emplace(path, texture);
+    return texture;
+}
+
+std::size_t Model::cpuBytes() const {
+    std::size_t bytes = 0;
+    for (auto const & mesh : meshes)
+        bytes += mesh.cpuBytes();
+    return bytes;
+}
+
+std::size_t Model::gpuBytes() const {
+    std::size_t bytes = 0;
+    for (auto const & mesh : meshes)
+        bytes += mesh.gpuBytes();
+    for (auto const & texture : textures_loaded)
+        bytes += texture.second.handle.bytes();
+    return bytes;
 }
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma){
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    Mirage::MipChain mips(filename);
+    return TextureFromMips(mips, path);
+}
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
+unsigned int TextureFromMips(Mirage::MipChain const &mips, const char *path){
+    if (!mips.valid())
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
\ No newline at end of file
+    return Mirage::uploadMipChain(mips);
+}
@@ -9,36 +9,84 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "asset_loader.hpp"
 #include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "mip_chain.hpp"
+#include "profiler.hpp"
 #include "shader.hpp"
+#include "texture_cache.hpp"
 
 #include <stb_image.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 using namespace std;
 
+// pixels of an image file decoded by stb_image, released with the object. decoding makes no GL calls,
+// so it can run on a worker thread. model textures go through Mirage::MipChain instead.
+struct DecodedImage
+{
+    explicit DecodedImage(string const &filename) : width(0), height(0), components(0)
+    {
+        pixels = stbi_load(filename.c_str(), &width, &height, &components, 0);
+    }
+    ~DecodedImage() { stbi_image_free(pixels); }
+
+    unsigned char *pixels;
+    int width, height, components;
+
+private:
+    DecodedImage(DecodedImage const &) = delete;
+    DecodedImage & operator=(DecodedImage const &) = delete;
+};
+
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+unsigned int TextureFromMips(Mirage::MipChain const &mips, const char *path);
 
 class Model
 {
 public:
     // model data 
-    vector<Mirage::Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    unordered_map<string, Mirage::Texture> textures_loaded;	// textures of this model by relative path; shared with other models through Mirage::TextureCache.
     vector<Mirage::Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    Mirage::VertexFormat format;
+    Mirage::CpuCopy cpuCopy;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false) : gammaCorrection(gamma), format(Mirage::VertexFormat::Full),
+                                                         cpuCopy(Mirage::CpuCopy::Release)
     {
         loadModel(path);
     }
 
+    // starts loading the model on the loader's worker threads; the meshes are in place once
+    // loader.finish() returns. the model must not move until then. static models can ask for
+    // the compact vertex format, which only keeps what shader.vert reads, and callers that pick
+    // or collide against the geometry can keep a CPU copy of it.
+    Model(string const &path, Mirage::AssetLoader &loader,
+          Mirage::VertexFormat format = Mirage::VertexFormat::Full,
+          Mirage::CpuCopy copy = Mirage::CpuCopy::Release, bool gamma = false);
+
+    // bytes held by the meshes' kept CPU arrays, and by the vertex, index and texture data on the GPU.
+    // textures shared with other models count for each of them.
+    std::size_t cpuBytes() const;
+    std::size_t gpuBytes() const;
+
+    // sphere around every mesh, in model space; empty until the meshes exist.
+    Mirage::Sphere const & bounds() const { return boundingSphere; }
+
     // draws the model, and thus all its meshes
     void Draw(Mirage::Shader &shader)
     {
@@ -47,17 +95,39 @@ public:
     }
 
 private:
+    Mirage::Sphere boundingSphere = Mirage::Sphere();
+
+    // vertex and index arrays and texture names read from a model file, before any GL object exists.
+    // the records point either into the mapped mesh cache or into the arrays below.
+    struct Staged
+    {
+        std::unique_ptr<Mirage::MeshCache> cache;
+        vector<Mirage::CachedMesh> meshes;
+        vector<vector<Mirage::Vertex>> vertices;
+        vector<vector<unsigned int>> indices;
+    };
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path);
 
+    // reads the meshes of a model file without touching GL.
+    bool stage(string const &path, Staged &staged);
+
+    // creates the meshes and their textures from staged data.
+    void createMeshes(Staged const &staged);
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene);
+    void processNode(aiNode *node, const aiScene *scene, Staged &staged);
+
+    void processMesh(aiMesh *mesh, const aiScene *scene, Staged &staged);
 
-    Mirage::Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+    // collects the type and path of all material textures of a given type.
+    void materialTextures(aiMaterial *mat, aiTextureType type, string typeName, vector<pair<string, string>> &textures);
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Mirage::Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName);
+    // returns the texture at the given path relative to the model from the texture cache, uploading
+    // the given mip chain, or else reading one, if no model has loaded the texture yet.
+    Mirage::Texture loadTexture(string const &path, string const &typeName,
+                                std::shared_ptr<Mirage::MipChain> const &mips = std::shared_ptr<Mirage::MipChain>());
 };
 
 
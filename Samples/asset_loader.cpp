@@ -0,0 +1,87 @@
+// Local Headers
+#include "asset_loader.hpp"
+
+// Standard Headers
+#include <algorithm>
+
+// Define Namespace
+namespace Mirage
+{
+    AssetLoader::AssetLoader(unsigned int threads) : mPending(0), mStopping(false)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threads; i++)
+            mWorkers.push_back(std::thread(& AssetLoader::work, this));
+    }
+
+    AssetLoader::~AssetLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mJobReady.notify_all();
+        for (auto & worker : mWorkers)
+            worker.join();
+    }
+
+    void AssetLoader::async(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back(std::move(job));
+            mPending++;
+        }
+        mJobReady.notify_one();
+    }
+
+    void AssetLoader::upload(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mUploads.push_back(std::move(job));
+        }
+        mUploadReady.notify_one();
+    }
+
+    void AssetLoader::finish()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (;;)
+        {
+            mUploadReady.wait(lock, [this] { return !mUploads.empty() || mPending == 0; });
+            if (mUploads.empty())
+                return;
+
+            // Run the whole batch without holding the lock so workers keep queueing
+            std::deque<std::function<void()>> batch;
+            batch.swap(mUploads);
+            lock.unlock();
+            for (auto & job : batch)
+                job();
+            lock.lock();
+        }
+    }
+
+    void AssetLoader::work()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (;;)
+        {
+            mJobReady.wait(lock, [this] { return !mJobs.empty() || mStopping; });
+            if (mJobs.empty())
+                return;
+
+            auto job = std::move(mJobs.front());
+            mJobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+
+            // The last job to finish wakes the context thread out of finish()
+            if (--mPending == 0)
+                mUploadReady.notify_all();
+        }
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+// Standard Headers
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // Runs loading work on a pool of worker threads while funnelling every
+    // OpenGL call back to the thread that owns the context. Workers parse files
+    // and decode images, then queue an upload; the context thread drains those
+    // uploads in finish(), so GL objects are only ever created there.
+    class AssetLoader
+    {
+    public:
+
+        // Implement Custom Constructor and Destructor; zero threads means one
+        // per hardware thread.
+        explicit AssetLoader(unsigned int threads = 0);
+        ~AssetLoader();
+
+        // Runs a job on a worker thread. Jobs may queue further jobs and uploads.
+        void async(std::function<void()> job);
+
+        // Queues work for the context thread; uploads run in the order queued.
+        void upload(std::function<void()> job);
+
+        // Called on the context thread: runs uploads as they arrive until every
+        // job has finished and the upload queue is empty.
+        void finish();
+
+        std::size_t threads() const { return mWorkers.size(); }
+
+    private:
+
+        // Disable Copying and Assignment
+        AssetLoader(AssetLoader const &) = delete;
+        AssetLoader & operator=(AssetLoader const &) = delete;
+
+        // Private Member Functions
+        void work();
+
+        // Private Member Variables
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mJobs;
+        std::deque<std::function<void()>> mUploads;
+        std::mutex mMutex;
+        std::condition_variable mJobReady;
+        std::condition_variable mUploadReady;
+        std::size_t mPending; // jobs queued or running
+        bool mStopping;
+    };
+};
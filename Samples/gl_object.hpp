@@ -0,0 +1,81 @@
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+// Define Namespace
+namespace Mirage
+{
+    // Sole owner of one OpenGL object name, deleted with the owner. Moving
+    // hands the name over and leaves the source empty; copies are disabled,
+    // so a name is never deleted twice. The traits say how to create and
+    // delete each kind of object.
+    template <typename Traits>
+    class GLObject
+    {
+    public:
+
+        // Implement Custom Constructors and Destructor
+        GLObject() : mName(0) {}
+        explicit GLObject(GLuint name) : mName(name) {}
+        ~GLObject() { reset(); }
+
+        GLObject(GLObject && other) noexcept : mName(other.release()) {}
+        GLObject & operator=(GLObject && other) noexcept
+        {
+            if (this != & other) reset(other.release());
+            return *this;
+        }
+
+        // Generates a new object; needs a current context.
+        static GLObject create() { return GLObject(Traits::create()); }
+
+        // Public Member Functions
+        GLuint get() const { return mName; }
+        explicit operator bool() const { return mName != 0; }
+
+        GLuint release()
+        {
+            GLuint name = mName;
+            mName = 0;
+            return name;
+        }
+
+        void reset(GLuint name = 0)
+        {
+            if (mName) Traits::destroy(mName);
+            mName = name;
+        }
+
+    private:
+
+        // Disable Copying and Assignment
+        GLObject(GLObject const &) = delete;
+        GLObject & operator=(GLObject const &) = delete;
+
+        // Private Member Variables
+        GLuint mName;
+    };
+
+    struct BufferTraits
+    {
+        static GLuint create() { GLuint name; glGenBuffers(1, & name); return name; }
+        static void destroy(GLuint name) { glDeleteBuffers(1, & name); }
+    };
+
+    struct VertexArrayTraits
+    {
+        static GLuint create() { GLuint name; glGenVertexArrays(1, & name); return name; }
+        static void destroy(GLuint name) { glDeleteVertexArrays(1, & name); }
+    };
+
+    struct TextureTraits
+    {
+        static GLuint create() { GLuint name; glGenTextures(1, & name); return name; }
+        static void destroy(GLuint name) { glDeleteTextures(1, & name); }
+    };
+
+    typedef GLObject<BufferTraits>      Buffer;
+    typedef GLObject<VertexArrayTraits> VertexArray;
+    typedef GLObject<TextureTraits>     TextureObject;
+};
@@ -0,0 +1,172 @@
+// Local Headers
+#include "mapped_file.hpp"
+
+// System Headers
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Standard Headers
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// Define Namespace
+namespace Mirage
+{
+    MappedFile::MappedFile(std::string const & path) : MappedFile()
+    {
+        open(path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(std::string const & path)
+    {
+        close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, & size) || size.QuadPart == 0) { CloseHandle(file); return false; }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void * view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+        mHandle  = file;
+        mMapping = mapping;
+        mSize    = static_cast<std::size_t>(size.QuadPart);
+        mData    = static_cast<unsigned char const *>(view);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) return false;
+        struct stat info;
+        if (fstat(file, & info) != 0 || info.st_size == 0) { ::close(file); return false; }
+        void * view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file); // the mapping keeps its own reference
+        if (view == MAP_FAILED) return false;
+        mSize = static_cast<std::size_t>(info.st_size);
+        mData = static_cast<unsigned char const *>(view);
+#endif
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (!mData) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(mData);
+        CloseHandle(static_cast<HANDLE>(mMapping));
+        CloseHandle(static_cast<HANDLE>(mHandle));
+#else
+        munmap(const_cast<unsigned char *>(mData), mSize);
+#endif
+        mData    = nullptr;
+        mSize    = 0;
+        mHandle  = nullptr;
+        mMapping = nullptr;
+    }
+
+    std::uint64_t hash(void const * data, std::size_t size, std::uint64_t seed)
+    {
+        auto bytes = static_cast<unsigned char const *>(data);
+        std::uint64_t value = seed;
+        for (std::size_t i = 0; i < size; i++)
+            value = (value ^ bytes[i]) * 1099511628211ULL;
+        return value;
+    }
+
+    std::string canonicalPath(std::string const & path)
+    {
+#if defined(_WIN32)
+        char resolved[_MAX_PATH];
+        if (!_fullpath(resolved, path.c_str(), sizeof(resolved))
+            || GetFileAttributesA(resolved) == INVALID_FILE_ATTRIBUTES)
+            return path;
+        return resolved;
+#else
+        char resolved[PATH_MAX];
+        if (!realpath(path.c_str(), resolved))
+            return path;
+        return resolved;
+#endif
+    }
+
+    bool makeDirectory(std::string const & path)
+    {
+#if defined(_WIN32)
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+    std::string cachePath(std::string const & source, std::uint64_t key, std::string const & extension)
+    {
+        auto slash = source.find_last_of("/\\");
+        auto name = source.substr(slash == std::string::npos ? 0 : slash + 1);
+        name = name.substr(0, name.rfind('.'));
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+        return "Cache/" + name + "-" + hex + "." + extension;
+    }
+
+    bool replaceFile(std::string const & path, void const * data, std::size_t size)
+    {
+        auto slash = path.find_last_of("/\\");
+        if (slash != std::string::npos && !makeDirectory(path.substr(0, slash)))
+            return false;
+
+        // A name of its own for every write, so that threads and processes
+        // writing the same entry never write into one another's file
+        static std::atomic<unsigned> counter(0);
+#if defined(_WIN32)
+        int process = _getpid();
+#else
+        int process = getpid();
+#endif
+        std::string temporary = path + "." + std::to_string(process) + "-" + std::to_string(counter++) + ".tmp";
+        {
+            std::ofstream fd(temporary, std::ios::binary | std::ios::trunc);
+            fd.write(static_cast<char const *>(data), size);
+            if (!fd)
+            {
+                fd.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+
+        // POSIX renames over the old file atomically; Windows will not
+        // rename onto an existing one
+#if defined(_WIN32)
+        std::remove(path.c_str());
+#endif
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Define Namespace
+namespace Mirage
+{
+    // Read-only memory mapping of a whole file, released on destruction. The
+    // contents are paged in by the operating system on first touch, so opening
+    // a large file costs nothing until it is read.
+    class MappedFile
+    {
+    public:
+
+        // Implement Custom Constructor and Destructor
+        MappedFile() : mData(nullptr), mSize(0), mHandle(nullptr), mMapping(nullptr) {}
+        explicit MappedFile(std::string const & path);
+        ~MappedFile();
+
+        // Public Member Functions
+        bool open(std::string const & path);
+        void close();
+
+        bool                   valid() const { return mData != nullptr; }
+        unsigned char const *  data()  const { return mData; }
+        std::size_t            size()  const { return mSize; }
+
+    private:
+
+        // Disable Copying and Assignment
+        MappedFile(MappedFile const &) = delete;
+        MappedFile & operator=(MappedFile const &) = delete;
+
+        // Private Member Variables
+        unsigned char const * mData;
+        std::size_t mSize;
+        void * mHandle;  // file handle on Windows, unused elsewhere
+        void * mMapping; // mapping handle on Windows, unused elsewhere
+    };
+
+    // 64-bit FNV-1a hash of a block of memory, optionally continuing a
+    // previous hash; used to key files cached on disk.
+    std::uint64_t hash(void const * data, std::size_t size,
+                       std::uint64_t seed = 14695981039346656037ULL);
+
+    // Absolute path of a file with links and dot segments resolved, so that
+    // two spellings of one file compare equal; the path as given if the file
+    // does not exist.
+    std::string canonicalPath(std::string const & path);
+
+    // Creates a directory if it does not exist yet; returns false on failure.
+    bool makeDirectory(std::string const & path);
+
+    // Path of the cache entry for a source file, Cache/<name>-<key>.<extension>,
+    // which keeps entries readable and lets stale ones be spotted.
+    std::string cachePath(std::string const & source, std::uint64_t key, std::string const & extension);
+
+    // Writes a file beside its destination and renames it into place, so that
+    // readers never see a partial file. Creates its directory if needed.
+    bool replaceFile(std::string const & path, void const * data, std::size_t size);
+};
@@ -3,82 +3,144 @@
 
 // Local Headers
 #include "mesh.hpp"
+#include "shader.hpp"
 
 // System Headers
+#include <glm/gtc/packing.hpp>
 #include <stb_image.h>
-#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 // Define Namespace
 namespace Mirage
 {
-    Mesh::Mesh(std::string const & filename) : Mesh()
-    {
-        // Load a Model from File
-        Assimp::Importer loader;
-        aiScene const * scene = loader.ReadFile(
-            PROJECT_SOURCE_DIR "/Mirage/Models/" + filename,
-            aiProcessPreset_TargetRealtime_MaxQuality |
-            aiProcess_OptimizeGraph                   |
-            aiProcess_FlipUVs);
-
-        // Walk the Tree of Scene Nodes
-        auto index = filename.find_last_of("/");
-        if (!scene) fprintf(stderr, "%s\n", loader.GetErrorString());
-        else parse(filename.substr(0, index), scene->mRootNode, scene);
-    }
-
-    Mesh::Mesh(std::vector<Vertex> const & vertices,
-               std::vector<GLuint> const & indices,
-               std::map<GLuint, std::string> const & textures)
-                    : mIndices(indices)
-                    , mVertices(vertices)
-                    , mTextures(textures)
-    {
-        // Bind a Vertex Array Object
-        glGenVertexArrays(1, & mVertexArray);
-        glBindVertexArray(mVertexArray);
-
-        // Copy Vertex Buffer Data
-        glGenBuffers(1, & mVertexBuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
-        glBufferData(GL_ARRAY_BUFFER,
-                     mVertices.size() * sizeof(Vertex),
-                   & mVertices.front(), GL_STATIC_DRAW);
-
-        // Copy Index Buffer Data
-        glGenBuffers(1, & mElementBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     mIndices.size() * sizeof(GLuint),
-                   & mIndices.front(), GL_STATIC_DRAW);
-
-        // Set Shader Attributes
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *) offsetof(Vertex, Position));
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *) offsetof(Vertex, Normal));
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *) offsetof(Vertex, uv));
-        glEnableVertexAttribArray(0); // Vertex Positions
-        glEnableVertexAttribArray(1); // Vertex Normals
-        glEnableVertexAttribArray(2); // Vertex UVs
-
-        // Cleanup Buffers
-        glBindVertexArray(0);
-        glDeleteBuffers(1, & mVertexBuffer);
-        glDeleteBuffers(1, & mElementBuffer);
+    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+               VertexFormat format, CpuCopy copy)
+                    : textures(std::move(textures))
+    {
+        assignUnits(this->textures);
+        setupMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), format);
+        if (copy == CpuCopy::Keep)
+        {
+            this->vertices = std::move(vertices);
+            this->indices = std::move(indices);
+        }
+    }
+
+    Mesh::Mesh(Vertex const * vertices, std::size_t vertexCount,
+               GLuint const * indices, std::size_t indexCount,
+               std::vector<Texture> textures,
+               VertexFormat format, CpuCopy copy)
+                    : textures(std::move(textures))
+    {
+        assignUnits(this->textures);
+        setupMesh(vertices, vertexCount, indices, indexCount, format);
+        if (copy == CpuCopy::Keep)
+        {
+            this->vertices.assign(vertices, vertices + vertexCount);
+            this->indices.assign(indices, indices + indexCount);
+        }
+    }
+
+    Sphere enclose(Sphere const & a, Sphere const & b)
+    {
+        float distance = glm::length(b.center - a.center);
+        if (distance + b.radius <= a.radius) return a;
+        if (distance + a.radius <= b.radius) return b;
+        Sphere sphere;
+        sphere.radius = (distance + a.radius + b.radius) * 0.5f;
+        sphere.center = a.center + (b.center - a.center) * ((sphere.radius - a.radius) / distance);
+        return sphere;
+    }
+
+    std::size_t Mesh::cpuBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
     }
 
     void Mesh::draw(GLuint shader)
     {
-        // bind appropriate textures
+        draw(shader, textures);
+    }
+
+    void Mesh::draw(GLuint shader, std::vector<Texture> const & material)
+    {
+        bindMaterial(shader, material);
+
+        // draw mesh
+        glBindVertexArray(mVertexArray.get());
+        glDrawElements(GL_TRIANGLES, mIndexCount, mIndexType, 0);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void Mesh::drawInstanced(GLuint shader, GLuint instances, GLsizei count, GLsizei first)
+    {
+        bindMaterial(shader, textures);
+        glBindVertexArray(mVertexArray.get());
+        drawElementsInstanced(instances, count, first);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void Mesh::drawElementsInstanced(GLuint instances, GLsizei count, GLsizei first)
+    {
+        // Point the per-instance attributes at the buffer; a mat4 takes four slots.
+        // Without base instances (GL 4.2), a run further in is drawn by moving the pointers
+        if (instances != mInstanceBuffer || first != mInstanceFirst)
+        {
+            std::size_t offset = static_cast<std::size_t>(first) * sizeof(Instance);
+            glBindBuffer(GL_ARRAY_BUFFER, instances);
+            for (GLuint column = 0; column < 4; column++)
+            {
+                glEnableVertexAttribArray(7 + column);
+                glVertexAttribPointer(7 + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                      (void*)(offset + offsetof(Instance, transform) + column * sizeof(glm::vec4)));
+                glVertexAttribDivisor(7 + column, 1);
+            }
+            glEnableVertexAttribArray(11);
+            glVertexAttribPointer(11, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, tint)));
+            glVertexAttribDivisor(11, 1);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            mInstanceBuffer = instances;
+            mInstanceFirst = first;
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, mIndexType, 0, count);
+    }
+
+    void Mesh::drawElements(GLuint firstIndex, GLsizei count) const
+    {
+        std::size_t size = mIndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        glDrawElements(GL_TRIANGLES, count, mIndexType, (void*)(firstIndex * size));
+    }
+
+    void Mesh::bindObjects(GLuint indices)
+    {
+        if (indices == mObjectBuffer)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, indices);
+        glEnableVertexAttribArray(12);
+        glVertexAttribIPointer(12, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+        glVertexAttribDivisor(12, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mObjectBuffer = indices;
+    }
+
+    void assignUnits(std::vector<Texture> & textures)
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        for (auto & texture : textures)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
+            // retrieve texture number (the N in texture_diffuseN)
             std::string number;
-            std::string name = textures[i].type;
+            std::string const & name = texture.type;
             if(name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if(name == "texture_specular")
@@ -87,46 +149,96 @@ namespace Mirage
                 number = std::to_string(normalNr++); // transfer unsigned int to string
             else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            texture.unit = Shader::textureUnit(name + number);
         }
+    }
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    void bindTextures(std::vector<Texture> const & material)
+    {
+        // The samplers already point at these units; see Shader::link
+        for (auto const & texture : material)
+        {
+            if (texture.unit < 0) continue;
+            glActiveTexture(GL_TEXTURE0 + texture.unit);
+            glBindTexture(GL_TEXTURE_2D, texture.handle ? texture.handle.use() : texture.name);
+        }
     }
 
-    void Mesh::parse(std::string const & path, aiNode const * node, aiScene const * scene)
+    void Mesh::bindMaterial(GLuint shader, std::vector<Texture> const & material)
     {
-        for (unsigned int i = 0; i < node->mNumMeshes; i++)
-            parse(path, scene->mMeshes[node->mMeshes[i]], scene);
-        for (unsigned int i = 0; i < node->mNumChildren; i++)
-            parse(path, node->mChildren[i], scene);
+        // Resolve the vertex decode uniforms once per program
+        if (shader != mDecodeProgram)
+        {
+            mScaleUniform      = glGetUniformLocation(shader, "positionScale");
+            mOffsetUniform     = glGetUniformLocation(shader, "positionOffset");
+            mOctahedralUniform = glGetUniformLocation(shader, "octahedralNormals");
+            mDecodeProgram = shader;
+        }
+
+        // Meshes of both layouts share programs, so the decode is set every draw;
+        // programs that do not declare it get location -1, which GL ignores
+        glUniform3fv(mScaleUniform, 1, & mPositionScale[0]);
+        glUniform3fv(mOffsetUniform, 1, & mPositionOffset[0]);
+        glUniform1i(mOctahedralUniform, mOctahedral);
+
+        bindTextures(material);
     }
 
-    void Mesh::setupMesh() {
+    void Mesh::setupMesh(Vertex const * vertices, std::size_t vertexCount,
+                         GLuint const * indices, std::size_t indexCount,
+                         VertexFormat format) {
+        mIndexCount = static_cast<GLsizei>(indexCount);
+        mFullBytes = vertexCount * sizeof(Vertex) + indexCount * sizeof(GLuint);
+
+        // Bounding sphere about the center of the box, for culling
+        glm::vec3 lower(0.0f), upper(0.0f);
+        for (std::size_t i = 0; i < vertexCount; i++)
+        {
+            lower = i ? glm::min(lower, vertices[i].Position) : vertices[i].Position;
+            upper = i ? glm::max(upper, vertices[i].Position) : vertices[i].Position;
+        }
+        mBounds.center = (lower + upper) * 0.5f;
+        mBounds.radius = 0.0f;
+        for (std::size_t i = 0; i < vertexCount; i++)
+            mBounds.radius = std::max(mBounds.radius, glm::length(vertices[i].Position - mBounds.center));
+
         // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        mVertexArray = VertexArray::create();
+        mVertexBuffer = Buffer::create();
+        mElementBuffer = Buffer::create();
+
+        glBindVertexArray(mVertexArray.get());
+
+        // Indices fit in 16 bits whenever the mesh has at most 65536 vertices
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBuffer.get());
+        if (vertexCount <= 65536)
+        {
+            std::vector<GLushort> narrow(indices, indices + indexCount);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLushort), narrow.data(), GL_STATIC_DRAW);
+            mIndexType = GL_UNSIGNED_SHORT;
+            mGpuBytes = indexCount * sizeof(GLushort);
+        }
+        else
+        {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+            mIndexType = GL_UNSIGNED_INT;
+            mGpuBytes = indexCount * sizeof(GLuint);
+        }
 
-        glBindVertexArray(VAO);
         // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer.get());
+        if (format == VertexFormat::Compact)
+        {
+            setupCompact(vertices, vertexCount);
+            glBindVertexArray(0);
+            return;
+        }
+
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
+        mGpuBytes += vertexCount * sizeof(Vertex);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -154,79 +266,73 @@ namespace Mirage
         glBindVertexArray(0);
     }
 
-    void Mesh::parse(std::string const & path, aiMesh const * mesh, aiScene const * scene)
+    // Maps a unit vector onto the octahedron |x| + |y| + |z| = 1, folding the
+    // lower half over the upper one, so that two components describe it
+    static glm::vec2 octahedral(glm::vec3 n)
     {
-        // Create Vertex Data from Mesh Node
-        std::vector<Vertex> vertices; Vertex vertex;
-        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-        {   if (mesh->mTextureCoords[0])
-            vertex.uv       = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
-            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-            vertex.Normal   = glm::vec3(mesh->mNormals[i].x,  mesh->mNormals[i].y,  mesh->mNormals[i].z);
-            vertices.push_back(vertex);
-        }
-
-        // Create Mesh Indices for Indexed Drawing
-        std::vector<GLuint> indices;
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-        for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
-            indices.push_back(mesh->mFaces[i].mIndices[j]);
-
-        // Load Mesh Textures into VRAM
-        std::map<GLuint, std::string> textures;
-        auto diffuse  = process(path, scene->mMaterials[mesh->mMaterialIndex], aiTextureType_DIFFUSE);
-        auto specular = process(path, scene->mMaterials[mesh->mMaterialIndex], aiTextureType_SPECULAR);
-        textures.insert(diffuse.begin(), diffuse.end());
-        textures.insert(specular.begin(), specular.end());
+        float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (sum == 0.0f) return glm::vec2(0.0f);
+        glm::vec2 e(n.x / sum, n.y / sum);
+        if (n.z < 0.0f)
+            e = glm::vec2((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+        return e;
+    }
 
-        // Create New Mesh Node
-        mSubMeshes.push_back(std::unique_ptr<Mesh>(new Mesh(vertices, indices, textures)));
+    static GLshort snorm16(float value)
+    {
+        return static_cast<GLshort>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
     }
 
-    std::map<GLuint, std::string> Mesh::process(std::string const & path,
-                                                aiMaterial * material,
-                                                aiTextureType type)
+    void Mesh::setupCompact(Vertex const * vertices, std::size_t vertexCount)
     {
-        std::map<GLuint, std::string> textures;
-        for(unsigned int i = 0; i < material->GetTextureCount(type); i++)
+        // Quantize positions over the bounding box, so precision follows mesh size
+        glm::vec3 lower(0.0f), upper(0.0f);
+        bool unitUVs = true;
+        for (std::size_t i = 0; i < vertexCount; i++)
         {
-            // Define Some Local Variables
-            GLenum format;
-            GLuint texture;
-            std::string mode;
-
-            // Load the Texture Image from File
-            aiString str; material->GetTexture(type, i, & str);
-            std::string filename = str.C_Str(); int width, height, channels;
-            filename = PROJECT_SOURCE_DIR "/Mirage/Models/" + path + "/" + filename;
-            unsigned char * image = stbi_load(filename.c_str(), & width, & height, & channels, 0);
-            if (!image) fprintf(stderr, "%s %s\n", "Failed to Load Texture", filename.c_str());
-
-            // Set the Correct Channel Format
-            switch (channels)
-            {
-                case 1 : format = GL_ALPHA;     break;
-                case 2 : format = GL_LUMINANCE; break;
-                case 3 : format = GL_RGB;       break;
-                case 4 : format = GL_RGBA;      break;
-            }
+            lower = i ? glm::min(lower, vertices[i].Position) : vertices[i].Position;
+            upper = i ? glm::max(upper, vertices[i].Position) : vertices[i].Position;
+            glm::vec2 uv = vertices[i].TexCoords;
+            unitUVs = unitUVs && uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+        }
+        glm::vec3 center = (lower + upper) * 0.5f;
+        glm::vec3 extent = (upper - lower) * 0.5f;
+
+        std::vector<CompactVertex> compact(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; i++)
+        {
+            Vertex const & vertex = vertices[i];
+            for (int axis = 0; axis < 3; axis++)
+                compact[i].position[axis] = extent[axis] > 0.0f
+                    ? snorm16((vertex.Position[axis] - center[axis]) / extent[axis]) : 0;
+            compact[i].position[3] = 0;
+
+            glm::vec2 normal = octahedral(vertex.Normal);
+            compact[i].normal[0] = snorm16(normal.x);
+            compact[i].normal[1] = snorm16(normal.y);
+
+            // Tiling coordinates fall outside [0, 1] and need the range of halves
+            for (int axis = 0; axis < 2; axis++)
+                compact[i].uv[axis] = unitUVs
+                    ? static_cast<GLushort>(std::lround(vertex.TexCoords[axis] * 65535.0f))
+                    : glm::packHalf1x16(vertex.TexCoords[axis]);
+        }
+        glBufferData(GL_ARRAY_BUFFER, compact.size() * sizeof(CompactVertex), compact.data(), GL_STATIC_DRAW);
+        mGpuBytes += compact.size() * sizeof(CompactVertex);
+
+        // Positions arrive as integers and are scaled back in the vertex shader;
+        // the other attributes keep their default values
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, unitUVs ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT, unitUVs ? GL_TRUE : GL_FALSE,
+                              sizeof(CompactVertex), (void*)offsetof(CompactVertex, uv));
 
-            // Bind Texture and Set Filtering Levels
-            glGenTextures(1, & texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexImage2D(GL_TEXTURE_2D, 0, format,
-                         width, height, 0, format, GL_UNSIGNED_BYTE, image);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            // Release Image Pointer and Store the Texture
-            stbi_image_free(image);
-                 if (type == aiTextureType_DIFFUSE)  mode = "diffuse";
-            else if (type == aiTextureType_SPECULAR) mode = "specular";
-            textures.insert(std::make_pair(texture, mode));
-        }   return textures;
+        mPositionScale  = extent / 32767.0f;
+        mPositionOffset = center;
+        mOctahedral     = true;
     }
 };
@@ -1,15 +1,15 @@
 #pragma once
 
+// Local Headers
+#include "gl_object.hpp"
+#include "texture_cache.hpp"
+
 // System Headers
-#include <assimp/importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 // Standard Headers
-#include <map>
-#include <memory>
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -36,77 +36,163 @@ namespace Mirage
         glm::vec2 uv;
     };
 
+    // Per-instance data for Mesh::drawInstanced, read by the vertex shader as a
+    // mat4 at attribute locations 7 to 10 and a vec4 tint at location 11.
+    struct Instance {
+        glm::mat4 transform;
+        glm::vec4 tint;
+    };
+
+    // Sphere bounding a mesh or a body, for culling.
+    struct Sphere {
+        glm::vec3 center;
+        float radius;
+    };
+
+    // Smallest sphere, centered on the line between them, that holds both.
+    Sphere enclose(Sphere const & a, Sphere const & b);
+
+    // Layout a static mesh is uploaded in. Full is the whole Vertex, for
+    // skinning and normal mapping. Compact keeps only what shader.vert reads,
+    // in 16 bytes: positions quantized to 16 bits over the mesh bounds,
+    // octahedral normals, and unorm16 UVs (half floats when they tile).
+    enum class VertexFormat { Full, Compact };
+
+    struct CompactVertex {
+        GLshort  position[4]; // the fourth is padding
+        GLshort  normal[2];
+        GLushort uv[2];
+    };
+
+    // A texture of a material. The unit is where it is bound for drawing,
+    // from its sampler name (see Shader::textureUnit), or -1 if no sampler
+    // reads it; assignUnits() fills it in. Textures that are not in the
+    // TextureCache, like those of VirtualTextures, have no handle and give
+    // their name instead.
     struct Texture {
-        unsigned int id;
+        TextureCache::Handle handle;
+        GLuint name = 0;
         std::string type;
         std::string path;
+        GLint unit = -1;
     };
 
+    // Numbers the textures of each type in order (texture_diffuse1,
+    // texture_diffuse2 and so on) and gives each the unit of its sampler.
+    void assignUnits(std::vector<Texture> & textures);
 
+    // Binds every texture of a material to its unit.
+    void bindTextures(std::vector<Texture> const & material);
+
+    // Whether a mesh keeps its vertex and index arrays on the CPU after
+    // upload, for picking or physics. Drawing never needs them.
+    enum class CpuCopy { Release, Keep };
+
+    // Static indexed triangle mesh. Owns its vertex array and buffers and
+    // can be moved but not copied; its textures live in the TextureCache.
     class Mesh
     {
     public:
 
-        // mesh Data
+        // mesh Data; the arrays are empty unless the mesh was built with CpuCopy::Keep
         std::vector<Vertex>       vertices;
         std::vector<unsigned int> indices;
         std::vector<Texture>      textures;
-        unsigned int VAO;
 
         // constructor
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) {
-            this->vertices = vertices;
-            this->indices = indices;
-            this->textures = textures;
-
-            // now that we have all the required data, set the vertex buffers and its attribute pointers.
-            setupMesh();
-        }
-
-        // Implement Default Constructor and Destructor
-         Mesh() { glGenVertexArrays(1, & mVertexArray); }
-        ~Mesh() { glDeleteVertexArrays(1, & mVertexArray); }
-
-        // Implement Custom Constructors
-        Mesh(std::string const & filename);
-        Mesh(std::vector<Vertex> const & vertices,
-             std::vector<GLuint> const & indices,
-             std::map<GLuint, std::string> const & textures);
+        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+             VertexFormat format = VertexFormat::Full, CpuCopy copy = CpuCopy::Release);
 
+        // Uploads the arrays straight from the caller, e.g. from a
+        // memory-mapped MeshCache file, copying them only if asked to.
+        Mesh(Vertex const * vertices, std::size_t vertexCount,
+             GLuint const * indices, std::size_t indexCount,
+             std::vector<Texture> textures,
+             VertexFormat format = VertexFormat::Full,
+             CpuCopy copy = CpuCopy::Release);
 
+        // Implement Move Constructor and Assignment
+        Mesh(Mesh &&) = default;
+        Mesh & operator=(Mesh &&) = default;
 
         // Public Member Functions
         void draw(GLuint shader);
 
-
-        Mesh(Mesh const &) = default;
+        // Draws the geometry with another set of textures, for meshes shared
+        // by objects that each look different.
+        void draw(GLuint shader, std::vector<Texture> const & material);
+
+        // Draws count copies of the mesh in one call, reading an Instance for
+        // each from the given buffer object, starting at instance first.
+        void drawInstanced(GLuint shader, GLuint instances, GLsizei count, GLsizei first = 0);
+
+        // Parts of a draw, for renderers that bind the vertex array and set
+        // the compact decode uniforms themselves; the draws expect the vertex
+        // array to be bound.
+        GLuint vertexArray() const { return mVertexArray.get(); }
+        glm::vec3 const & positionScale() const { return mPositionScale; }
+        glm::vec3 const & positionOffset() const { return mPositionOffset; }
+        bool octahedralNormals() const { return mOctahedral; }
+        void drawElements() const { glDrawElements(GL_TRIANGLES, mIndexCount, mIndexType, 0); }
+        void drawElements(GLuint firstIndex, GLsizei count) const;
+        void drawElementsInstanced(GLuint instances, GLsizei count, GLsizei first);
+        GLsizei indexCount() const { return mIndexCount; }
+        GLenum indexType() const { return mIndexType; }
+
+        // Feeds the unsigned integer attribute at location 12, one value per
+        // instance, from a buffer; a renderer that fills it with 0, 1, 2 and
+        // so on can pick a draw's per-object data by its base instance.
+        // Expects the vertex array to be bound, like the draws.
+        void bindObjects(GLuint indices);
+
+        // Bytes of vertex and index data on the GPU, and what the same mesh
+        // would take as Full vertices with 32-bit indices.
+        std::size_t gpuBytes()  const { return mGpuBytes; }
+        std::size_t fullBytes() const { return mFullBytes; }
+
+        // Bytes held on the CPU by the kept vertex and index arrays.
+        std::size_t cpuBytes() const;
+
+        // Sphere around the vertices, centered on their bounding box.
+        Sphere const & bounds() const { return mBounds; }
 
     private:
 
         // Disable Copying and Assignment
+        Mesh(Mesh const &) = delete;
         Mesh & operator=(Mesh const &) = delete;
 
         // Private Member Functions
-        void parse(std::string const & path, aiNode const * node, aiScene const * scene);
-        void parse(std::string const & path, aiMesh const * mesh, aiScene const * scene);
-        std::map<GLuint, std::string> process(std::string const & path,
-                                              aiMaterial * material,
-                                              aiTextureType type);
-
-        void setupMesh();
-
-        // Private Member Containers
-        std::vector<std::shared_ptr<Mesh>> mSubMeshes;
-        std::vector<GLuint> mIndices;
-        std::vector<Vertex> mVertices;
-        std::map<GLuint, std::string> mTextures;
+        void setupMesh(Vertex const * vertices, std::size_t vertexCount,
+                       GLuint const * indices, std::size_t indexCount,
+                       VertexFormat format);
+        void setupCompact(Vertex const * vertices, std::size_t vertexCount);
+        void bindMaterial(GLuint shader, std::vector<Texture> const & material);
 
         // Private Member Variables
-        GLuint mVertexArray;
-        GLuint mVertexBuffer;
-        GLuint mElementBuffer;
-
-        // render data
-        unsigned int VBO, EBO;
+        VertexArray mVertexArray;
+        Buffer mVertexBuffer;
+        Buffer mElementBuffer;
+        GLsizei mIndexCount = 0;
+        GLenum mIndexType = GL_UNSIGNED_INT;
+
+        // Decoding of compact positions, identity for Full meshes
+        glm::vec3 mPositionScale = glm::vec3(1.0f);
+        glm::vec3 mPositionOffset = glm::vec3(0.0f);
+        bool mOctahedral = false;
+        std::size_t mGpuBytes = 0;
+        std::size_t mFullBytes = 0;
+        Sphere mBounds = Sphere();
+
+        // Instance buffer and first instance currently wired into the vertex array
+        GLuint mInstanceBuffer = 0;
+        GLsizei mInstanceFirst = 0;
+        GLuint mObjectBuffer = 0;
+
+        // Decode uniform locations in the last program drawn with
+        GLuint mDecodeProgram = 0;
+        GLint mScaleUniform = -1;
+        GLint mOffsetUniform = -1;
+        GLint mOctahedralUniform = -1;
     };
 };
@@ -0,0 +1,149 @@
+// Local Headers
+#include "mesh_cache.hpp"
+
+// Standard Headers
+#include <cstring>
+
+// Define Namespace
+namespace Mirage
+{
+    static const char magic[8] = { 'M', 'I', 'R', 'M', 'E', 'S', 'H', '\0' };
+
+    // On-Disk Layout: Header, One Record per Mesh, Then the Arrays and Texture
+    // Names Each Record Points at, Vertex and Index Arrays Aligned to 16 Bytes
+    struct FileHeader
+    {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t vertexSize;
+        std::uint64_t key;
+        std::uint32_t meshCount;
+        std::uint32_t reserved;
+    };
+
+    struct MeshRecord
+    {
+        std::uint64_t vertexOffset;
+        std::uint64_t indexOffset;
+        std::uint64_t textureOffset;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t textureCount;
+        std::uint32_t reserved;
+    };
+
+    MeshCache::MeshCache(std::string const & source, unsigned int flags) : mKey(0)
+    {
+        MappedFile file(source);
+        if (!file.valid()) return;
+
+        std::uint32_t layout[3] = { Version, static_cast<std::uint32_t>(sizeof(Vertex)), flags };
+        mKey = hash(layout, sizeof(layout), hash(file.data(), file.size()));
+        mPath = cachePath(source, mKey, "mesh");
+    }
+
+    bool MeshCache::load()
+    {
+        mMeshes.clear();
+        if (mPath.empty() || !mFile.open(mPath)) return false;
+
+        // Reject anything that does not match this build exactly
+        auto data = mFile.data();
+        auto size = mFile.size();
+        FileHeader header;
+        if (size < sizeof(header)) return false;
+        std::memcpy(& header, data, sizeof(header));
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != Version
+            || header.vertexSize != sizeof(Vertex)
+            || header.key != mKey
+            || header.meshCount > (size - sizeof(header)) / sizeof(MeshRecord))
+            return false;
+
+        for (std::uint32_t i = 0; i < header.meshCount; i++)
+        {
+            MeshRecord record;
+            std::memcpy(& record, data + sizeof(header) + i * sizeof(record), sizeof(record));
+            if (record.vertexOffset % 16 || record.indexOffset % 16
+                || record.vertexOffset > size || record.indexOffset > size || record.textureOffset > size
+                || record.vertexCount > (size - record.vertexOffset) / sizeof(Vertex)
+                || record.indexCount > (size - record.indexOffset) / sizeof(std::uint32_t))
+                return false;
+
+            CachedMesh mesh;
+            mesh.vertices    = reinterpret_cast<Vertex const *>(data + record.vertexOffset);
+            mesh.vertexCount = record.vertexCount;
+            mesh.indices     = reinterpret_cast<std::uint32_t const *>(data + record.indexOffset);
+            mesh.indexCount  = record.indexCount;
+
+            // Texture names as pairs of lengths followed by the characters
+            std::size_t offset = static_cast<std::size_t>(record.textureOffset);
+            for (std::uint32_t t = 0; t < record.textureCount; t++)
+            {
+                std::uint32_t lengths[2];
+                if (size - offset < sizeof(lengths)) return false;
+                std::memcpy(lengths, data + offset, sizeof(lengths));
+                offset += sizeof(lengths);
+                if (size - offset < std::size_t(lengths[0]) + lengths[1]) return false;
+                auto text = reinterpret_cast<char const *>(data + offset);
+                mesh.textures.push_back(std::make_pair(std::string(text, lengths[0]),
+                                                       std::string(text + lengths[0], lengths[1])));
+                offset += lengths[0] + lengths[1];
+            }
+            mMeshes.push_back(mesh);
+        }
+        return true;
+    }
+
+    bool MeshCache::store(std::vector<CachedMesh> const & meshes) const
+    {
+        if (mPath.empty() || meshes.empty()) return false;
+
+        std::vector<unsigned char> buffer;
+        auto append = [& buffer](void const * data, std::size_t size) {
+            auto bytes = static_cast<unsigned char const *>(data);
+            buffer.insert(buffer.end(), bytes, bytes + size);
+        };
+        auto align = [& buffer]() {
+            buffer.resize((buffer.size() + 15) & ~std::size_t(15), 0);
+            return static_cast<std::uint64_t>(buffer.size());
+        };
+
+        FileHeader header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version    = Version;
+        header.vertexSize = sizeof(Vertex);
+        header.key        = mKey;
+        header.meshCount  = static_cast<std::uint32_t>(meshes.size());
+        append(& header, sizeof(header));
+
+        // Reserve the records, then fill them in as the arrays are appended
+        std::vector<MeshRecord> records(meshes.size());
+        buffer.resize(buffer.size() + records.size() * sizeof(MeshRecord));
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            CachedMesh const & mesh = meshes[i];
+            MeshRecord & record = records[i];
+            record.vertexCount  = mesh.vertexCount;
+            record.indexCount   = mesh.indexCount;
+            record.textureCount = static_cast<std::uint32_t>(mesh.textures.size());
+            record.reserved     = 0;
+
+            record.vertexOffset = align();
+            append(mesh.vertices, mesh.vertexCount * sizeof(Vertex));
+            record.indexOffset = align();
+            append(mesh.indices, mesh.indexCount * sizeof(std::uint32_t));
+            record.textureOffset = buffer.size();
+            for (auto const & texture : mesh.textures)
+            {
+                std::uint32_t lengths[2] = { static_cast<std::uint32_t>(texture.first.size()),
+                                             static_cast<std::uint32_t>(texture.second.size()) };
+                append(lengths, sizeof(lengths));
+                append(texture.first.data(), texture.first.size());
+                append(texture.second.data(), texture.second.size());
+            }
+        }
+        std::memcpy(buffer.data() + sizeof(header), records.data(), records.size() * sizeof(MeshRecord));
+        return replaceFile(mPath, buffer.data(), buffer.size());
+    }
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+// Local Headers
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+// Standard Headers
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // One mesh read back from the cache. The arrays point into the mapped
+    // file and stay valid for as long as the MeshCache that returned them.
+    struct CachedMesh
+    {
+        Vertex const *        vertices;
+        std::uint32_t         vertexCount;
+        std::uint32_t const * indices;
+        std::uint32_t         indexCount;
+        std::vector<std::pair<std::string, std::string>> textures; // type, path
+    };
+
+    // Binary cache of the final vertex and index arrays of an imported model,
+    // so later runs can skip Assimp and hand the mapped arrays straight to
+    // glBufferData. Entries live in Cache/ and are keyed by a hash of the
+    // source file contents, the import flags, the Vertex layout and the file
+    // format version; any change to those simply misses and re-imports.
+    class MeshCache
+    {
+    public:
+
+        // Bump whenever the file layout or the import post-processing changes.
+        static const std::uint32_t Version = 1;
+
+        // Implement Custom Constructor
+        MeshCache(std::string const & source, unsigned int flags);
+
+        // Maps and validates the cache entry; false if it is missing or stale.
+        bool load();
+
+        // Writes the meshes of a freshly imported model as the cache entry.
+        bool store(std::vector<CachedMesh> const & meshes) const;
+
+        std::vector<CachedMesh> const & meshes() const { return mMeshes; }
+        std::string const & path() const { return mPath; }
+
+    private:
+
+        // Disable Copying and Assignment
+        MeshCache(MeshCache const &) = delete;
+        MeshCache & operator=(MeshCache const &) = delete;
+
+        // Private Member Variables
+        MappedFile mFile;
+        std::uint64_t mKey;
+        std::string mPath;
+        std::vector<CachedMesh> mMeshes;
+    };
+};
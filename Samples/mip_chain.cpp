@@ -0,0 +1,175 @@
+// Local Headers
+#include "mip_chain.hpp"
+
+// System Headers
+#include <stb_image.h>
+
+// Standard Headers
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+// Define Namespace
+namespace Mirage
+{
+    static const char magic[8] = { 'M', 'I', 'R', 'M', 'I', 'P', 'S', '\0' };
+    static std::atomic<int> resolutionLimit(0);
+
+    // On-Disk Layout: Header, One Record per Level, Then the Pixels of Each
+    // Level, Tightly Packed Rows, Each Level Aligned to 16 Bytes
+    struct FileHeader
+    {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t components;
+        std::uint64_t key;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t levelCount;
+        std::uint32_t reserved;
+    };
+
+    struct LevelRecord
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    void MipChain::setMaxResolution(int pixels) { resolutionLimit = std::max(0, pixels); }
+    int  MipChain::maxResolution() { return resolutionLimit; }
+
+    std::uint64_t MipChain::key(std::string const & image)
+    {
+        MappedFile source(image);
+        if (!source.valid()) return 0;
+        std::uint32_t version = Version;
+        return hash(& version, sizeof(version), hash(source.data(), source.size()));
+    }
+
+    MipChain::MipChain(std::string const & image) : mKey(key(image)), mComponents(0)
+    {
+        if (!mKey) return;
+
+        std::string path = cachePath(image, mKey, "mips");
+        if (mFile.open(path) && open(mFile.data(), mFile.size()))
+            return;
+        mFile.close();
+
+        // First run: decode and downsample once, then serve from the written
+        // file, or from memory if the cache cannot be written
+        std::vector<unsigned char> file;
+        if (!build(image, file))
+            return;
+        if (replaceFile(path, file.data(), file.size())
+            && mFile.open(path) && open(mFile.data(), mFile.size()))
+            return;
+        mFile.close();
+        mMemory.swap(file);
+        open(mMemory.data(), mMemory.size());
+    }
+
+    bool MipChain::open(unsigned char const * data, std::size_t size)
+    {
+        mLevels.clear();
+        FileHeader header;
+        if (size < sizeof(header)) return false;
+        std::memcpy(& header, data, sizeof(header));
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != Version
+            || header.key != mKey
+            || header.components < 1 || header.components > 4
+            || header.levelCount == 0
+            || header.levelCount > (size - sizeof(header)) / sizeof(LevelRecord))
+            return false;
+
+        std::vector<Level> levels;
+        for (std::uint32_t i = 0; i < header.levelCount; i++)
+        {
+            LevelRecord record;
+            std::memcpy(& record, data + sizeof(header) + i * sizeof(record), sizeof(record));
+            if (record.offset > size || record.size > size - record.offset
+                || record.size != std::uint64_t(record.width) * record.height * header.components)
+                return false;
+            Level level = { static_cast<int>(record.width), static_cast<int>(record.height),
+                            data + record.offset, static_cast<std::size_t>(record.size) };
+            levels.push_back(level);
+        }
+
+        // Drop the levels above the limit, always keeping the smallest one
+        int limit = resolutionLimit;
+        std::size_t first = 0;
+        while (limit > 0 && first + 1 < levels.size()
+               && std::max(levels[first].width, levels[first].height) > limit)
+            first++;
+        mLevels.assign(levels.begin() + first, levels.end());
+        mComponents = static_cast<int>(header.components);
+        return true;
+    }
+
+    bool MipChain::build(std::string const & image, std::vector<unsigned char> & file) const
+    {
+        int width, height, components;
+        unsigned char * pixels = stbi_load(image.c_str(), & width, & height, & components, 0);
+        if (!pixels) return false;
+
+        // Level sizes halve, rounding down, until both reach one
+        std::vector<LevelRecord> records;
+        std::size_t offset = sizeof(FileHeader);
+        for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        {
+            LevelRecord record = { 0, std::uint64_t(w) * h * components,
+                                   static_cast<std::uint32_t>(w), static_cast<std::uint32_t>(h) };
+            records.push_back(record);
+            if (w == 1 && h == 1) break;
+        }
+        offset += records.size() * sizeof(LevelRecord);
+        for (auto & record : records)
+        {
+            offset = (offset + 15) & ~std::size_t(15);
+            record.offset = offset;
+            offset += static_cast<std::size_t>(record.size);
+        }
+
+        file.assign(offset, 0);
+        FileHeader header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version    = Version;
+        header.components = static_cast<std::uint32_t>(components);
+        header.key        = mKey;
+        header.width      = static_cast<std::uint32_t>(width);
+        header.height     = static_cast<std::uint32_t>(height);
+        header.levelCount = static_cast<std::uint32_t>(records.size());
+        std::memcpy(file.data(), & header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), records.data(), records.size() * sizeof(LevelRecord));
+        std::memcpy(file.data() + records[0].offset, pixels, static_cast<std::size_t>(records[0].size));
+        stbi_image_free(pixels);
+
+        // Box filter each level from the one above; odd edges reuse the last texel
+        for (std::size_t i = 1; i < records.size(); i++)
+        {
+            LevelRecord const & above = records[i - 1];
+            LevelRecord const & below = records[i];
+            unsigned char const * src = file.data() + above.offset;
+            unsigned char * dst = file.data() + below.offset;
+            std::size_t stride = std::size_t(above.width) * components;
+            for (std::uint32_t y = 0; y < below.height; y++)
+            {
+                std::uint32_t y0 = std::min(2 * y, above.height - 1), y1 = std::min(2 * y + 1, above.height - 1);
+                for (std::uint32_t x = 0; x < below.width; x++)
+                {
+                    std::uint32_t x0 = std::min(2 * x, above.width - 1), x1 = std::min(2 * x + 1, above.width - 1);
+                    for (int c = 0; c < components; c++)
+                    {
+                        unsigned sum = src[y0 * stride + x0 * components + c] + src[y0 * stride + x1 * components + c]
+                                     + src[y1 * stride + x0 * components + c] + src[y1 * stride + x1 * components + c];
+                        *dst++ = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+// Local Headers
+#include "mapped_file.hpp"
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // Every mip level of an image, decoded and downsampled once and then kept
+    // in a KTX-like cache file: a header, a table of levels, and the raw 8-bit
+    // pixels of each level from the largest down to 1x1. Later runs map the
+    // file and upload the levels as they are, with no image decode and no
+    // glGenerateMipmap. Entries live in Cache/ and are keyed by a hash of the
+    // source image contents and the format version.
+    class MipChain
+    {
+    public:
+
+        // Bump whenever the file layout or the downsampling filter changes.
+        static const std::uint32_t Version = 1;
+
+        // Largest width or height handed out by any chain, or 0 for no limit.
+        // Levels above it are skipped without ever being read from disk.
+        static void setMaxResolution(int pixels);
+        static int maxResolution();
+
+        struct Level
+        {
+            int width;
+            int height;
+            unsigned char const * pixels;
+            std::size_t size;
+        };
+
+        // Maps the cache entry of an image, building and writing it first if
+        // it is missing or stale. Makes no GL calls.
+        explicit MipChain(std::string const & image);
+
+        // Key of an image's cache entry, for files derived from it; 0 if the
+        // image cannot be read.
+        static std::uint64_t key(std::string const & image);
+
+        bool valid() const { return !mLevels.empty(); }
+        int components() const { return mComponents; }
+
+        // Levels within the maximum resolution, largest first.
+        std::vector<Level> const & levels() const { return mLevels; }
+
+    private:
+
+        // Disable Copying and Assignment
+        MipChain(MipChain const &) = delete;
+        MipChain & operator=(MipChain const &) = delete;
+
+        // Private Member Functions
+        bool open(unsigned char const * data, std::size_t size);
+        bool build(std::string const & image, std::vector<unsigned char> & file) const;
+
+        // Private Member Variables
+        MappedFile mFile;
+        std::vector<unsigned char> mMemory; // used when the cache cannot be written
+        std::vector<Level> mLevels;
+        std::uint64_t mKey;
+        int mComponents;
+    };
+};
@@ -0,0 +1,307 @@
+// Local Headers
+#include "profiler.hpp"
+
+// Standard Headers
+#include <map>
+
+// Define Namespace
+namespace Mirage
+{
+    // A ring slot is rewritten in place, so it carries a sequence number: odd
+    // while a writer fills it, even once the event of the claim it records is
+    // complete. Fields are atomic so that a reader racing a writer is merely
+    // told to skip the slot.
+    struct Profiler::Slot
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<char const *>  name;
+        std::atomic<std::int64_t>  begin;
+        std::atomic<std::int64_t>  end;
+        std::atomic<std::uint32_t> thread;
+    };
+
+    // Numbers CPU threads from 1 in the order they first record.
+    static std::uint32_t threadNumber()
+    {
+        static std::atomic<std::uint32_t> next(1);
+        thread_local std::uint32_t number = next.fetch_add(1);
+        return number;
+    }
+
+    // Writes a name as a JSON string.
+    static void writeString(FILE * file, char const * name)
+    {
+        fputc('"', file);
+        for (char const * c = name; *c; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', file);
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                fputc(*c, file);
+        }
+        fputc('"', file);
+    }
+
+    Profiler::Scope::Scope(char const * name)
+    {
+        Profiler & profiler = Profiler::global();
+        mName = profiler.enabled() ? name : nullptr;
+        mBegin = mName ? profiler.now() : 0;
+    }
+
+    Profiler::Scope::~Scope()
+    {
+        if (mName)
+        {
+            Profiler & profiler = Profiler::global();
+            profiler.record(mName, mBegin, profiler.now());
+        }
+    }
+
+    Profiler::GpuScope::GpuScope(char const * name)
+        : mSpan(Profiler::global().beginGpu(name))
+    {
+    }
+
+    Profiler::GpuScope::~GpuScope()
+    {
+        Profiler::global().endGpu(mSpan);
+    }
+
+    Profiler & Profiler::global()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Profiler()
+        : mOrigin(std::chrono::steady_clock::now())
+        , mEnabled(false)
+        , mHead(0)
+        , mCurrent(0)
+        , mFrameBegin(-1)
+        , mGpuOffset(0)
+        , mDropped(0)
+    {
+        mUsed[0] = mUsed[1] = 0;
+        mLastEnded[0] = mLastEnded[1] = -1;
+    }
+
+    // The query objects are left to the context, which is gone by the time
+    // the profiler is destroyed at exit.
+    Profiler::~Profiler()
+    {
+    }
+
+    void Profiler::enable(bool on)
+    {
+        // The ring is only allocated for a profiler that is used
+        if (on && !mSlots)
+        {
+            mSlots.reset(new Slot[Capacity]);
+            for (std::size_t i = 0; i < Capacity; i++)
+                mSlots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        mEnabled.store(on, std::memory_order_release);
+    }
+
+    std::int64_t Profiler::now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mOrigin).count();
+    }
+
+    void Profiler::record(char const * name, std::int64_t begin, std::int64_t end)
+    {
+        if (enabled())
+            push(name, begin, end, threadNumber());
+    }
+
+    void Profiler::push(char const * name, std::int64_t begin, std::int64_t end, std::uint32_t thread)
+    {
+        std::uint64_t index = mHead.fetch_add(1, std::memory_order_relaxed);
+        Slot & slot = mSlots[index & (Capacity - 1)];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.thread.store(thread, std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    int Profiler::beginGpu(char const * name)
+    {
+        if (!enabled())
+            return -1;
+
+        std::vector<Query> & queries = mQueries[mCurrent];
+        std::size_t & used = mUsed[mCurrent];
+        if (used == queries.size())
+        {
+            Query query;
+            glGenQueries(1, & query.begin);
+            glGenQueries(1, & query.end);
+            queries.push_back(query);
+        }
+        Query & query = queries[used];
+        query.name = name;
+        query.cpuBegin = now();
+        query.ended = false;
+        glQueryCounter(query.begin, GL_TIMESTAMP);
+        return static_cast<int>(used++);
+    }
+
+    void Profiler::endGpu(int span)
+    {
+        if (span < 0 || static_cast<std::size_t>(span) >= mUsed[mCurrent])
+            return;
+        Query & query = mQueries[mCurrent][span];
+        glQueryCounter(query.end, GL_TIMESTAMP);
+        query.ended = true;
+        mLastEnded[mCurrent] = span;
+        record(query.name, query.cpuBegin, now());
+    }
+
+    void Profiler::frame()
+    {
+        if (!enabled())
+        {
+            mUsed[0] = mUsed[1] = 0;
+            mLastEnded[0] = mLastEnded[1] = -1;
+            mFrameBegin = -1;
+            return;
+        }
+
+        std::int64_t end = now();
+        if (mFrameBegin >= 0)
+            record("frame", mFrameBegin, end);
+        mFrameBegin = end;
+
+        // Line the GPU clock up with ours; both tick steadily, so once a frame
+        // is plenty
+        GLint64 gpu = 0;
+        glGetInteger64v(GL_TIMESTAMP, & gpu);
+        mGpuOffset = now() - gpu;
+
+        // The other set was issued a frame ago; read it back if it is done,
+        // then time the next frame with it
+        unsigned previous = mCurrent ^ 1;
+        collect(mQueries[previous], mUsed[previous], mLastEnded[previous]);
+        mUsed[previous] = 0;
+        mLastEnded[previous] = -1;
+        mCurrent = previous;
+    }
+
+    void Profiler::collect(std::vector<Query> & queries, std::size_t used, int last)
+    {
+        if (used == 0 || last < 0)
+            return;
+
+        // Queries finish in the order they were issued, so the end issued
+        // last being available means they all are. Scopes nest, so that is
+        // the end of the outermost span rather than of the last one begun.
+        GLint available = 0;
+        glGetQueryObjectiv(queries[last].end, GL_QUERY_RESULT_AVAILABLE, & available);
+        if (!available)
+        {
+            mDropped++;
+            return;
+        }
+        for (std::size_t i = 0; i < used; i++)
+        {
+            if (!queries[i].ended)
+                continue;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(queries[i].begin, GL_QUERY_RESULT, & begin);
+            glGetQueryObjectui64v(queries[i].end, GL_QUERY_RESULT, & end);
+            push(queries[i].name, static_cast<std::int64_t>(begin) + mGpuOffset,
+                 static_cast<std::int64_t>(end) + mGpuOffset, 0);
+        }
+    }
+
+    std::vector<Profiler::Event> Profiler::events() const
+    {
+        std::vector<Event> events;
+        if (!mSlots)
+            return events;
+
+        std::uint64_t head = mHead.load(std::memory_order_acquire);
+        std::uint64_t first = head > Capacity ? head - Capacity : 0;
+        events.reserve(static_cast<std::size_t>(head - first));
+        for (std::uint64_t index = first; index < head; index++)
+        {
+            Slot const & slot = mSlots[index & (Capacity - 1)];
+            std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2)
+                continue;
+            Event event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.begin = slot.begin.load(std::memory_order_relaxed);
+            event.end = slot.end.load(std::memory_order_relaxed);
+            event.thread = slot.thread.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+                events.push_back(event);
+        }
+        return events;
+    }
+
+    bool Profiler::exportTrace(std::string const & path) const
+    {
+        FILE * file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+
+        // Complete events in microseconds, one process, a track per thread
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}");
+        for (auto const & event : events())
+        {
+            fprintf(file, ",\n{\"name\":");
+            writeString(file, event.name);
+            fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.thread ? "cpu" : "gpu", event.thread, event.begin / 1.0e3, (event.end - event.begin) / 1.0e3);
+        }
+        fprintf(file, "\n]}\n");
+        return fclose(file) == 0;
+    }
+
+    void Profiler::report(FILE * stream) const
+    {
+        struct Totals
+        {
+            std::size_t calls;
+            double cpu;
+            std::size_t gpuCalls;
+            double gpu;
+        };
+        std::map<std::string, Totals> totals;
+        for (auto const & event : events())
+        {
+            Totals & total = totals.insert(std::make_pair(std::string(event.name), Totals())).first->second;
+            double milliseconds = (event.end - event.begin) / 1.0e6;
+            if (event.thread)
+            {
+                total.calls++;
+                total.cpu += milliseconds;
+            }
+            else
+            {
+                total.gpuCalls++;
+                total.gpu += milliseconds;
+            }
+        }
+
+        fprintf(stream, "%-16s %10s %10s %10s\n", "[ms]", "calls", "cpu", "gpu");
+        for (auto const & entry : totals)
+        {
+            Totals const & total = entry.second;
+            fprintf(stream, "%-16s %10zu %10.3f %10.3f\n", entry.first.c_str(), total.calls,
+                    total.calls ? total.cpu / total.calls : 0.0,
+                    total.gpuCalls ? total.gpu / total.gpuCalls : 0.0);
+        }
+        if (mDropped)
+            fprintf(stream, "GPU timings of %llu frames were not ready and were dropped\n",
+                    static_cast<unsigned long long>(mDropped));
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+// Standard Headers
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // Process-wide recorder of named, timed spans of work. CPU spans come from
+    // scopes on any thread. GPU spans come from pairs of GL timestamp queries
+    // around the same scopes on the thread that owns the GL context. The pairs
+    // are double-buffered by frame and read back one frame late, and only if
+    // the GPU has got that far, so timing never waits on the GPU. A frame whose
+    // results are not ready yet loses its GPU spans.
+    //
+    // Spans go into a fixed ring of the most recent Capacity events. Writers
+    // claim slots with one atomic increment and never block; readers skip any
+    // slot being rewritten. The ring can be exported at any time as a Chrome
+    // trace (chrome://tracing, Perfetto), with the GPU spans on a track of
+    // their own, or summarized per name.
+    //
+    // Disabled, which is the default, a scope costs one atomic load and
+    // records nothing.
+    class Profiler
+    {
+    public:
+
+        // Events kept; older ones are overwritten.
+        static const std::size_t Capacity = 1 << 16;
+
+        // A finished span, in nanoseconds since the profiler was created.
+        // Thread 0 is the GPU; CPU threads are numbered from 1 in the order
+        // they first record.
+        struct Event
+        {
+            char const *  name;
+            std::int64_t  begin;
+            std::int64_t  end;
+            std::uint32_t thread;
+        };
+
+        // Times the enclosing block on the calling thread. The name must
+        // outlive the profiler; string literals do.
+        class Scope
+        {
+        public:
+            explicit Scope(char const * name);
+            ~Scope();
+
+        private:
+            Scope(Scope const &) = delete;
+            Scope & operator=(Scope const &) = delete;
+
+            char const * mName;
+            std::int64_t mBegin;
+        };
+
+        // Times the enclosing block on the CPU and the GL commands it issues
+        // on the GPU. Only for the thread that owns the GL context.
+        class GpuScope
+        {
+        public:
+            explicit GpuScope(char const * name);
+            ~GpuScope();
+
+        private:
+            GpuScope(GpuScope const &) = delete;
+            GpuScope & operator=(GpuScope const &) = delete;
+
+            int mSpan;
+        };
+
+        // The profiler shared by every thread.
+        static Profiler & global();
+
+        void enable(bool on);
+        bool enabled() const { return mEnabled.load(std::memory_order_acquire); }
+
+        // Nanoseconds since the profiler was created.
+        std::int64_t now() const;
+
+        // Adds a CPU span on the calling thread.
+        void record(char const * name, std::int64_t begin, std::int64_t end);
+
+        // Opens and closes a GPU span, for spans that are not a block; begin
+        // returns -1 when disabled, which end ignores. GL thread only.
+        int  beginGpu(char const * name);
+        void endGpu(int span);
+
+        // Marks the end of a frame: collects the GPU spans of the frame before
+        // if they are ready and starts timing the next. GL thread only.
+        void frame();
+
+        // The events in the ring, in the order they were recorded; GPU spans
+        // are recorded a frame after their CPU spans.
+        std::vector<Event> events() const;
+
+        // Frames whose GPU spans were dropped because they were not ready.
+        std::uint64_t dropped() const { return mDropped; }
+
+        // Writes the ring as Chrome trace JSON.
+        bool exportTrace(std::string const & path) const;
+
+        // Prints the count and mean CPU and GPU milliseconds of every name.
+        void report(FILE * stream) const;
+
+    private:
+
+        Profiler();
+        ~Profiler();
+
+        // Disable Copying and Assignment
+        Profiler(Profiler const &) = delete;
+        Profiler & operator=(Profiler const &) = delete;
+
+        struct Slot;
+
+        // A GPU span waiting for its queries
+        struct Query
+        {
+            GLuint       begin;
+            GLuint       end;
+            char const * name;
+            std::int64_t cpuBegin;
+            bool         ended;
+        };
+
+        // Private Member Functions
+        void push(char const * name, std::int64_t begin, std::int64_t end, std::uint32_t thread);
+        void collect(std::vector<Query> & queries, std::size_t used, int last);
+
+        // Private Member Variables
+        std::chrono::steady_clock::time_point mOrigin;
+        std::atomic<bool> mEnabled;
+        std::unique_ptr<Slot[]> mSlots;
+        std::atomic<std::uint64_t> mHead;
+
+        // GL Thread Only
+        std::vector<Query> mQueries[2];
+        std::size_t mUsed[2];
+        int mLastEnded[2]; // span whose end was issued last, or -1
+        unsigned mCurrent;
+        std::int64_t mFrameBegin;
+        std::int64_t mGpuOffset; // CPU time minus GPU time, in nanoseconds
+        std::uint64_t mDropped;  // frames whose GPU spans were not ready
+    };
+}
@@ -1,55 +1,154 @@
 // Local Headers
+#include "mapped_file.hpp"
+#include "profiler.hpp"
 #include "shader.hpp"
 
 // Standard Headers
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 // Define Namespace
 namespace Mirage
 {
+    static const char magic[8] = { 'M', 'I', 'R', 'P', 'R', 'O', 'G', '\0' };
+
+    // On-Disk Layout: Header, Then the Driver's Binary as Returned
+    struct ProgramHeader
+    {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t format;
+        std::uint64_t key;
+        std::uint64_t length;
+    };
+
+    // Program binaries are core in GL 4.1 and an extension before; the
+    // extension is only checked when the loader was generated with it
+    static bool programBinaries()
+    {
+#if defined(GL_ARB_get_program_binary)
+        if (GLAD_GL_ARB_get_program_binary)
+            return true;
+#endif
+        return GLAD_GL_VERSION_4_1 != 0;
+    }
+
     Shader & Shader::activate()
     {
         glUseProgram(mProgram);
         return *this;
     }
 
+    void Shader::bind(unsigned int location, int value) { glUniform1i(location, value); }
     void Shader::bind(unsigned int location, float value) { glUniform1f(location, value); }
+    void Shader::bind(unsigned int location, glm::vec3 const & vector) { glUniform3fv(location, 1, glm::value_ptr(vector)); }
+    void Shader::bind(unsigned int location, glm::vec4 const & vector) { glUniform4fv(location, 1, glm::value_ptr(vector)); }
     void Shader::bind(unsigned int location, glm::mat4 const & matrix)
     { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix)); }
 
     Shader & Shader::attach(std::string const & filename)
     {
-        // Load GLSL Shader Source from File
+        // Load GLSL Shader Source from File; it is compiled by link() if needed
         std::string path = "Shaders/";
         std::ifstream fd(path + filename);
         auto src = std::string(std::istreambuf_iterator<char>(fd),
                                (std::istreambuf_iterator<char>()));
+        mSources.push_back(std::make_pair(filename, src));
+        return *this;
+    }
+
+    void Shader::compile()
+    {
+        for (auto const & file : mSources)
+        {
+            // Create a Shader Object
+            const char * source = file.second.c_str();
+            auto shader = create(file.first);
+            glShaderSource(shader, 1, & source, nullptr);
+            glCompileShader(shader);
+            glGetShaderiv(shader, GL_COMPILE_STATUS, & mStatus);
 
-        // Create a Shader Object
-        const char * source = src.c_str();
-        auto shader = create(filename);
-        glShaderSource(shader, 1, & source, nullptr);
-        glCompileShader(shader);
-        glGetShaderiv(shader, GL_COMPILE_STATUS, & mStatus);
+            std::cout<<shader<<std::endl;
 
-        std::cout<<shader<<std::endl;
+            // Display the Build Log on Error
+            if (mStatus == false)
+            {
+                glGetShaderiv(shader, GL_INFO_LOG_LENGTH, & mLength);
+                std::unique_ptr<char[]> buffer(new char[mLength]);
+                glGetShaderInfoLog(shader, mLength, nullptr, buffer.get());
+                fprintf(stderr, "%s\n%s", file.first.c_str(), buffer.get());
+            }
 
-        // Display the Build Log on Error
-        if (mStatus == false)
+            // Attach the Shader and Free Allocated Memory
+            glAttachShader(mProgram, shader);
+            glDeleteShader(shader);
+        }
+    }
+
+    std::uint64_t Shader::key() const
+    {
+        // Binaries are only good for the driver that made them
+        std::uint32_t version = Version;
+        std::uint64_t key = hash(& version, sizeof(version));
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
         {
-            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, & mLength);
-            std::unique_ptr<char[]> buffer(new char[mLength]);
-            glGetShaderInfoLog(shader, mLength, nullptr, buffer.get());
-            fprintf(stderr, "%s\n%s", filename.c_str(), buffer.get());
+            auto text = reinterpret_cast<char const *>(glGetString(name));
+            if (text) key = hash(text, std::strlen(text) + 1, key);
         }
+        for (auto const & file : mSources)
+        {
+            key = hash(file.first.c_str(), file.first.size() + 1, key);
+            key = hash(file.second.data(), file.second.size(), key);
+        }
+        return key;
+    }
 
-        // Attach the Shader and Free Allocated Memory
-        glAttachShader(mProgram, shader);
-        glDeleteShader(shader);
-        return *this;
+    bool Shader::restore(std::string const & path, std::uint64_t key)
+    {
+        MappedFile file(path);
+        if (!file.valid()) return false;
+
+        // Reject anything that does not match these sources and driver exactly
+        ProgramHeader header;
+        if (file.size() < sizeof(header)) return false;
+        std::memcpy(& header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != Version
+            || header.key != key
+            || header.length > file.size() - sizeof(header))
+            return false;
+
+        glProgramBinary(mProgram, header.format, file.data() + sizeof(header), static_cast<GLsizei>(header.length));
+        glGetProgramiv(mProgram, GL_LINK_STATUS, & mStatus);
+        return mStatus == GL_TRUE;
+    }
+
+    void Shader::store(std::string const & path, std::uint64_t key)
+    {
+        GLint length = 0;
+        glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, & length);
+        if (length <= 0) return;
+
+        std::vector<unsigned char> buffer(sizeof(ProgramHeader) + length);
+        GLsizei written = 0;
+        GLenum format = 0;
+        glGetProgramBinary(mProgram, length, & written, & format, buffer.data() + sizeof(ProgramHeader));
+        if (written <= 0) return;
+
+        ProgramHeader header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = Version;
+        header.format = format;
+        header.key = key;
+        header.length = static_cast<std::uint64_t>(written);
+        std::memcpy(buffer.data(), & header, sizeof(header));
+        if (!replaceFile(path, buffer.data(), sizeof(header) + written))
+            fprintf(stderr, "Failed to write program cache %s\n", path.c_str());
     }
 
     GLuint Shader::create(std::string const & filename)
@@ -65,16 +164,98 @@ namespace Mirage
 
     Shader & Shader::link()
     {
-        glLinkProgram(mProgram);
-        glGetProgramiv(mProgram, GL_LINK_STATUS, & mStatus);
-        if(mStatus == false)
+        Profiler::Scope scope("link program");
+
+        // Drivers without binary formats cannot restore programs at all
+        GLint formats = 0;
+        if (programBinaries())
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, & formats);
+        std::string files;
+        for (auto const & file : mSources)
+            files += (files.empty() ? "" : "+") + file.first;
+        std::uint64_t programKey = formats > 0 ? key() : 0;
+        std::string path = formats > 0 ? cachePath(files, programKey, "program") : std::string();
+
+        // A rejected binary leaves the program unlinked, ready to be built
+        if (path.empty() || !restore(path, programKey))
         {
-            glGetProgramiv(mProgram, GL_INFO_LOG_LENGTH, & mLength);
-            std::unique_ptr<char[]> buffer(new char[mLength]);
-            glGetProgramInfoLog(mProgram, mLength, nullptr, buffer.get());
-            fprintf(stderr, "%s", buffer.get());
+            compile();
+            if (!path.empty())
+                glProgramParameteri(mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(mProgram);
+            glGetProgramiv(mProgram, GL_LINK_STATUS, & mStatus);
+            if(mStatus == false)
+            {
+                glGetProgramiv(mProgram, GL_INFO_LOG_LENGTH, & mLength);
+                std::unique_ptr<char[]> buffer(new char[mLength]);
+                glGetProgramInfoLog(mProgram, mLength, nullptr, buffer.get());
+                fprintf(stderr, "%s", buffer.get());
+            }
+            else if (!path.empty())
+                store(path, programKey);
         }
+        mSources.clear();
         assert(mStatus == true);
+
+        // Resolve Every Active Uniform Once; Arrays Are Reported as name[0]
+        mUniforms.clear();
+        std::vector<std::pair<GLint, GLint>> samplers;
+        GLint count = 0, longest = 0;
+        glGetProgramiv(mProgram, GL_ACTIVE_UNIFORMS, & count);
+        glGetProgramiv(mProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, & longest);
+        std::unique_ptr<char[]> name(new char[longest + 1]);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLint size; GLenum type;
+            glGetActiveUniform(mProgram, i, longest + 1, nullptr, & size, & type, name.get());
+            GLint location = glGetUniformLocation(mProgram, name.get());
+            if (location == -1) continue; // member of a uniform block
+            std::string key = name.get();
+            mUniforms[key.substr(0, key.find('['))] = location;
+            GLint unit = textureUnit(key);
+            if (unit >= 0) samplers.push_back(std::make_pair(location, unit));
+        }
+
+        // Sampler Units Are Program State, so They Are Set Here and Never Again
+        if (!samplers.empty())
+        {
+            GLint current = 0;
+            glGetIntegerv(GL_CURRENT_PROGRAM, & current);
+            glUseProgram(mProgram);
+            for (auto const & sampler : samplers)
+                glUniform1i(sampler.first, sampler.second);
+            glUseProgram(current);
+        }
+
+        // Attach the Shared Camera Block
+        GLuint block = glGetUniformBlockIndex(mProgram, "Camera");
+        if (block != GL_INVALID_INDEX)
+            glUniformBlockBinding(mProgram, block, CameraBlock);
         return *this;
     }
+
+    GLint Shader::textureUnit(std::string const & sampler)
+    {
+        static const char * const kinds[] = {
+            "texture_diffuse", "texture_specular", "texture_normal", "texture_height"
+        };
+        for (int kind = 0; kind < 4; kind++)
+        {
+            std::string prefix = kinds[kind];
+            if (sampler.size() != prefix.size() + 1 || sampler.compare(0, prefix.size(), prefix) != 0)
+                continue;
+            char number = sampler.back();
+            if (number >= '1' && number <= '4')
+                return kind * 4 + (number - '1');
+        }
+        if (sampler == "virtual_pages") return 17;
+        if (sampler == "virtual_atlas") return 18;
+        return -1;
+    }
+
+    GLint Shader::uniform(std::string const & name) const
+    {
+        auto found = mUniforms.find(name);
+        return found == mUniforms.end() ? -1 : found->second;
+    }
 };
\ No newline at end of file
@@ -6,15 +6,41 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Standard Headers
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Define Namespace
 namespace Mirage
 {
+    // A GLSL program built from files in Shaders/. attach() only reads a
+    // source; link() compiles and links them all, unless a binary of the same
+    // sources linked by the same driver is in Cache/, in which case the
+    // program is restored from it without compiling anything. A binary the
+    // driver rejects, which drivers may do after any update, is rebuilt from
+    // the sources and replaced.
     class Shader
     {
     public:
 
+        // Bump whenever the layout of cached program binaries changes.
+        static const std::uint32_t Version = 1;
+
+        // Binding point of the uniform block named Camera; link() attaches the
+        // block of every program to it, so one buffer feeds them all.
+        static const GLuint CameraBlock = 0;
+
+        // Texture unit of a material sampler, fixed by its name so that any
+        // program reads a material from the same units: texture_diffuseN
+        // uses unit N - 1, texture_specularN 3 + N, texture_normalN 7 + N and
+        // texture_heightN 11 + N, for N up to 4. The samplers of virtual
+        // textures, virtual_pages and virtual_atlas, use units 17 and 18,
+        // past the objects buffer of the render queue. Other names get -1.
+        // link() points the samplers of every program at their units once.
+        static GLint textureUnit(std::string const & sampler);
+
         // Implement Custom Constructor and Destructor
         Shader() { mProgram = glCreateProgram(); }
         ~Shader() { glDeleteProgram(mProgram); }
@@ -26,12 +52,19 @@ namespace Mirage
         GLuint   get() { return mProgram; }
         Shader & link();
 
+        // Location of an active uniform, looked up in the table built by link(),
+        // or -1 if the program has no such uniform.
+        GLint uniform(std::string const & name) const;
+
         // Wrap Calls to glUniform
+        void bind(unsigned int location, int value);
         void bind(unsigned int location, float value);
+        void bind(unsigned int location, glm::vec3 const & vector);
+        void bind(unsigned int location, glm::vec4 const & vector);
         void bind(unsigned int location, glm::mat4 const & matrix);
         template<typename T> Shader & bind(std::string const & name, T&& value)
         {
-            int location = glGetUniformLocation(mProgram, name.c_str());
+            int location = uniform(name);
             if (location == -1) fprintf(stderr, "Missing Uniform: %s\n", name.c_str());
             else bind(location, std::forward<T>(value));
             return *this;
@@ -43,10 +76,22 @@ namespace Mirage
         Shader(Shader const &) = delete;
         Shader & operator=(Shader const &) = delete;
 
+        // Private Member Functions
+        std::uint64_t key() const;
+        bool restore(std::string const & path, std::uint64_t key);
+        void store(std::string const & path, std::uint64_t key);
+        void compile();
+
         // Private Member Variables
         GLuint mProgram;
         GLint  mStatus;
         GLint  mLength;
 
+        // Sources Attached Since the Last Link, by File Name
+        std::vector<std::pair<std::string, std::string>> mSources;
+
+        // Active Uniform Locations by Name
+        std::unordered_map<std::string, GLint> mUniforms;
+
     };
 };
\ No newline at end of file
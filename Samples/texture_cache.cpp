@@ -0,0 +1,264 @@
+// Local Headers
+#include "texture_cache.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    struct TextureCache::Entry
+    {
+        TextureCache * cache;
+        std::string path;
+        std::shared_ptr<MipChain> mips;
+        TextureObject texture;
+        std::size_t firstLevel;
+        std::size_t bytes;
+        std::uint64_t lastDrawn;
+        int references;
+    };
+
+    GLuint uploadMipChain(MipChain const & mips, std::size_t firstLevel)
+    {
+        GLuint texture;
+        glGenTextures(1, & texture);
+        if (!mips.valid())
+            return texture;
+
+        GLenum format;
+        if (mips.components() == 1)
+            format = GL_RED;
+        else if (mips.components() == 2)
+            format = GL_RG;
+        else if (mips.components() == 3)
+            format = GL_RGB;
+        else
+            format = GL_RGBA;
+
+        // Upload every level as stored; rows are tightly packed
+        auto const & levels = mips.levels();
+        firstLevel = std::min(firstLevel, levels.size() - 1);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (std::size_t level = firstLevel; level < levels.size(); level++)
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level - firstLevel), format,
+                         levels[level].width, levels[level].height,
+                         0, format, GL_UNSIGNED_BYTE, levels[level].pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - firstLevel) - 1);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return texture;
+    }
+
+    TextureCache::Handle::Handle(Entry * entry) : mEntry(entry)
+    {
+        mEntry->references++;
+    }
+
+    TextureCache::Handle::Handle(Handle const & other) : mEntry(other.mEntry)
+    {
+        if (mEntry) mEntry->references++;
+    }
+
+    TextureCache::Handle & TextureCache::Handle::operator=(Handle other)
+    {
+        std::swap(mEntry, other.mEntry);
+        return *this;
+    }
+
+    TextureCache::Handle::~Handle()
+    {
+        if (mEntry) mEntry->references--;
+    }
+
+    GLuint TextureCache::Handle::use() const
+    {
+        if (!mEntry) return 0;
+        mEntry->lastDrawn = mEntry->cache->mFrame;
+        return mEntry->texture.get();
+    }
+
+    std::size_t TextureCache::Handle::bytes() const
+    {
+        return mEntry ? mEntry->bytes : 0;
+    }
+
+    TextureCache::TextureCache() : mBudget(0), mBytes(0), mReduced(0), mFrame(1) {}
+    TextureCache::~TextureCache() {}
+
+    TextureCache & TextureCache::global()
+    {
+        // Never destroyed: textures must go before the context, not at exit
+        static TextureCache * cache = new TextureCache;
+        return *cache;
+    }
+
+    TextureCache::Handle TextureCache::acquire(std::string const & path)
+    {
+        std::string key = canonicalPath(path);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = mEntries.find(key);
+            if (found != mEntries.end())
+                return Handle(found->second.get());
+        }
+        return acquire(path, std::make_shared<MipChain>(path));
+    }
+
+    TextureCache::Handle TextureCache::acquire(std::string const & path, std::shared_ptr<MipChain> const & mips)
+    {
+        std::string key = canonicalPath(path);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = mEntries.find(key);
+            if (found != mEntries.end())
+                return Handle(found->second.get());
+        }
+
+        // A missing image still gets an (empty) texture, so it is not retried on every load
+        std::unique_ptr<Entry> entry(new Entry());
+        entry->cache = this;
+        entry->path = key;
+        entry->mips = mips;
+        entry->firstLevel = 0;
+        entry->bytes = 0;
+        entry->lastDrawn = mFrame;
+        entry->references = 0;
+        if (mips && mips->valid())
+            resize(*entry, 0);
+        else
+        {
+            fprintf(stderr, "Texture failed to load at path: %s\n", path.c_str());
+            entry->mips.reset();
+            entry->texture = TextureObject::create();
+        }
+
+        // Only this thread inserts, so the key is still free
+        Entry * inserted = entry.get();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.emplace(key, std::move(entry));
+        return Handle(inserted);
+    }
+
+    bool TextureCache::contains(std::string const & path) const
+    {
+        std::string key = canonicalPath(path);
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.count(key) != 0;
+    }
+
+    std::size_t TextureCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.size();
+    }
+
+    void TextureCache::collect()
+    {
+        std::uint64_t frame = mFrame++;
+        bool overBudget = mBudget != 0 && mBytes > mBudget;
+        if (!overBudget && mReduced == 0)
+            return;
+
+        std::vector<Entry *> entries;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto const & entry : mEntries)
+                entries.push_back(entry.second.get());
+        }
+
+        if (overBudget)
+        {
+            std::sort(entries.begin(), entries.end(), [](Entry const * a, Entry const * b) {
+                return a->lastDrawn < b->lastDrawn;
+            });
+
+            // Textures no model refers to go first, then levels of idle ones
+            for (auto & entry : entries)
+                if (mBytes > mBudget && entry->references == 0)
+                {
+                    erase(*entry);
+                    entry = nullptr;
+                }
+            entries.erase(std::remove(entries.begin(), entries.end(), nullptr), entries.end());
+
+            for (bool dropped = true; dropped && mBytes > mBudget; )
+            {
+                dropped = false;
+                for (auto entry : entries)
+                {
+                    if (mBytes <= mBudget) break;
+                    if (entry->lastDrawn >= frame || !entry->mips || !entry->mips->valid())
+                        continue;
+                    auto const & levels = entry->mips->levels();
+                    std::size_t next = entry->firstLevel + 1;
+                    if (next < levels.size()
+                        && std::max(levels[next].width, levels[next].height) >= MinResolution)
+                    {
+                        resize(*entry, next);
+                        dropped = true;
+                    }
+                }
+            }
+            return;
+        }
+
+        // Give one level back to a reduced texture drawn in the last frame, one per
+        // frame so that the uploads are spread out
+        for (auto entry : entries)
+        {
+            if (entry->firstLevel == 0 || entry->lastDrawn < frame)
+                continue;
+            std::size_t cost = entry->mips->levels()[entry->firstLevel - 1].size;
+            if (mBudget == 0 || mBytes + cost <= mBudget)
+            {
+                resize(*entry, entry->firstLevel - 1);
+                break;
+            }
+        }
+    }
+
+    void TextureCache::clear()
+    {
+        std::vector<Entry *> unused;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto const & entry : mEntries)
+                if (entry.second->references == 0)
+                    unused.push_back(entry.second.get());
+        }
+        for (auto entry : unused)
+            erase(*entry);
+    }
+
+    void TextureCache::resize(Entry & entry, std::size_t firstLevel)
+    {
+        auto const & levels = entry.mips->levels();
+        std::size_t bytes = 0;
+        for (std::size_t level = firstLevel; level < levels.size(); level++)
+            bytes += levels[level].size;
+
+        entry.texture = TextureObject(uploadMipChain(*entry.mips, firstLevel));
+        mBytes = mBytes - entry.bytes + bytes;
+        mReduced = mReduced - (entry.firstLevel != 0) + (firstLevel != 0);
+        entry.bytes = bytes;
+        entry.firstLevel = firstLevel;
+    }
+
+    void TextureCache::erase(Entry & entry)
+    {
+        mBytes -= entry.bytes;
+        mReduced -= entry.firstLevel != 0;
+        std::string key = entry.path;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.erase(key);
+    }
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+// Local Headers
+#include "gl_object.hpp"
+#include "mip_chain.hpp"
+
+// System Headers
+#include <glad/glad.h>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Define Namespace
+namespace Mirage
+{
+    // Creates a 2D texture from the levels of a mip chain, starting at the
+    // given level, with repeat wrapping and trilinear filtering.
+    GLuint uploadMipChain(MipChain const & mips, std::size_t firstLevel = 0);
+
+    // Process-wide store of model textures, keyed by canonical path so that a
+    // texture shared by several models is decoded and uploaded only once.
+    // Handles count references to an entry; entries nobody references stay
+    // resident for later loads until memory runs short.
+    //
+    // Under a GPU memory budget, collect() first evicts unreferenced textures,
+    // least recently drawn first. If that is not enough, textures that were
+    // not drawn in the last frame lose their largest level, one at a time and
+    // never below MinResolution. A reduced texture gets its levels back once
+    // it is drawn again and they fit in the budget.
+    //
+    // contains() may be called from any thread; everything else belongs to the
+    // thread that owns the GL context.
+    class TextureCache
+    {
+        struct Entry;
+
+    public:
+
+        // Shared reference to a cached texture; the entry lives at least as
+        // long as any handle to it.
+        class Handle
+        {
+        public:
+
+            // Implement Custom Constructors and Destructor
+            Handle() : mEntry(nullptr) {}
+            Handle(Handle const & other);
+            Handle & operator=(Handle other);
+            ~Handle();
+
+            // Texture name to bind for drawing; marks the texture as drawn
+            // in the current frame. The name changes when levels are dropped.
+            GLuint use() const;
+
+            // Bytes of the levels currently on the GPU.
+            std::size_t bytes() const;
+
+            // Identity of the cached texture, shared by every handle to it;
+            // unlike the name, it stays the same while it is referenced.
+            void const * id() const { return mEntry; }
+
+            explicit operator bool() const { return mEntry != nullptr; }
+
+        private:
+
+            friend class TextureCache;
+            explicit Handle(Entry * entry);
+
+            Entry * mEntry;
+        };
+
+        // Smallest width or height a referenced texture is reduced to.
+        static const int MinResolution = 64;
+
+        // The cache shared by every model.
+        static TextureCache & global();
+
+        // Returns the texture of an image, building it from the image's mip
+        // chain if it is not resident yet. The second form takes a chain that
+        // was already decoded, typically on a worker thread.
+        Handle acquire(std::string const & path);
+        Handle acquire(std::string const & path, std::shared_ptr<MipChain> const & mips);
+
+        // True if the image is resident, so a loader can skip decoding it.
+        bool contains(std::string const & path) const;
+
+        // GPU memory allowed for textures, in bytes, or 0 for no limit.
+        void setBudget(std::size_t bytes) { mBudget = bytes; }
+        std::size_t budget() const { return mBudget; }
+
+        // Bytes and number of textures currently resident.
+        std::size_t bytes() const { return mBytes; }
+        std::size_t size() const;
+
+        // Ends a frame: enforces the budget and restores reduced textures.
+        void collect();
+
+        // Deletes every texture that is no longer referenced.
+        void clear();
+
+    private:
+
+        // Implement Default Constructor and Destructor
+        TextureCache();
+        ~TextureCache();
+
+        // Disable Copying and Assignment
+        TextureCache(TextureCache const &) = delete;
+        TextureCache & operator=(TextureCache const &) = delete;
+
+        // Private Member Functions
+        void resize(Entry & entry, std::size_t firstLevel);
+        void erase(Entry & entry);
+
+        // Private Member Variables
+        std::unordered_map<std::string, std::unique_ptr<Entry>> mEntries;
+        mutable std::mutex mMutex; // guards mEntries against concurrent contains()
+        std::size_t mBudget;
+        std::size_t mBytes;
+        std::size_t mReduced; // entries missing their largest levels
+        std::uint64_t mFrame;
+    };
+};
@@ -0,0 +1,177 @@
+// Local Headers
+#include "tile_file.hpp"
+#include "mip_chain.hpp"
+
+// System Headers
+#include <stb_image.h>
+
+// Standard Headers
+#include <atomic>
+#include <cstring>
+
+// Define Namespace
+namespace Mirage
+{
+    static const char magic[8] = { 'M', 'I', 'R', 'T', 'I', 'L', 'E', 'S' };
+    static std::atomic<int> resolutionThreshold(4096);
+
+    // Largest number of tiles across, so that a tile position fits in a byte
+    static const int maxTiles = 256;
+
+    // On-Disk Layout: Header, Then Every Tile, Level by Level, Aligned to 16 Bytes
+    struct FileHeader
+    {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t components;
+        std::uint64_t key;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t levelCount;
+        std::uint32_t reserved;
+    };
+
+    static const std::size_t tileOffset = (sizeof(FileHeader) + 15) & ~std::size_t(15);
+
+    static bool powerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+    // Whether a level 0 of this size can be cut into tiles.
+    static bool tileable(int width, int height)
+    {
+        return powerOfTwo(width) && powerOfTwo(height)
+            && width >= TileFile::TileSize && height >= TileFile::TileSize
+            && width <= maxTiles * TileFile::TileSize && height <= maxTiles * TileFile::TileSize;
+    }
+
+    void TileFile::setMinResolution(int pixels) { resolutionThreshold = std::max(0, pixels); }
+    int  TileFile::minResolution() { return resolutionThreshold; }
+
+    TileFile::TileFile(std::string const & image)
+        : mPath(image)
+        , mTiles(nullptr)
+        , mKey(0)
+        , mWidth(0)
+        , mHeight(0)
+        , mComponents(0)
+        , mLevels(0)
+        , mTilesX(0)
+        , mTilesY(0)
+    {
+        // Small maps are turned away by their header alone
+        int width, height, components;
+        int threshold = resolutionThreshold;
+        if (threshold <= 0 || !stbi_info(image.c_str(), & width, & height, & components)
+            || std::max(width, height) < threshold)
+            return;
+
+        // The tiles are cut from the mip chain, so they are keyed by its key
+        // and resolution limit
+        std::uint64_t mips = MipChain::key(image);
+        if (!mips) return;
+        std::uint32_t version = Version;
+        int limit = MipChain::maxResolution();
+        mKey = hash(& version, sizeof(version), mips);
+        mKey = hash(& limit, sizeof(limit), mKey);
+
+        std::string path = cachePath(image, mKey, "tiles");
+        if (mFile.open(path) && open(mFile.data(), mFile.size()))
+            return;
+        mFile.close();
+
+        std::vector<unsigned char> file;
+        if (!build(image, file))
+            return;
+        if (replaceFile(path, file.data(), file.size())
+            && mFile.open(path) && open(mFile.data(), mFile.size()))
+            return;
+        mFile.close();
+        mMemory.swap(file);
+        open(mMemory.data(), mMemory.size());
+    }
+
+    void TileFile::layout(int width, int height)
+    {
+        mWidth = width;
+        mHeight = height;
+        mTilesX = width / TileSize;
+        mTilesY = height / TileSize;
+        mLevels = 1;
+        while ((std::max(mTilesX, mTilesY) >> (mLevels - 1)) > 1)
+            mLevels++;
+        mFirstTile.assign(1, 0);
+        for (int level = 0; level < mLevels; level++)
+            mFirstTile.push_back(mFirstTile.back() + std::size_t(tilesX(level)) * tilesY(level));
+    }
+
+    bool TileFile::open(unsigned char const * data, std::size_t size)
+    {
+        mTiles = nullptr;
+        FileHeader header;
+        if (size < tileOffset) return false;
+        std::memcpy(& header, data, sizeof(header));
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != Version
+            || header.key != mKey
+            || (header.components != 3 && header.components != 4)
+            || !tileable(static_cast<int>(header.width), static_cast<int>(header.height)))
+            return false;
+
+        mComponents = static_cast<int>(header.components);
+        layout(static_cast<int>(header.width), static_cast<int>(header.height));
+        if (header.levelCount != static_cast<std::uint32_t>(mLevels)
+            || (size - tileOffset) / tileBytes() < mFirstTile.back())
+            return false;
+        mTiles = data + tileOffset;
+        return true;
+    }
+
+    bool TileFile::build(std::string const & image, std::vector<unsigned char> & file)
+    {
+        MipChain mips(image);
+        if (!mips.valid() || (mips.components() != 3 && mips.components() != 4))
+            return false;
+        auto const & levels = mips.levels();
+        if (!tileable(levels[0].width, levels[0].height))
+            return false;
+        mComponents = mips.components();
+        layout(levels[0].width, levels[0].height);
+
+        file.assign(tileOffset + mFirstTile.back() * tileBytes(), 0);
+        FileHeader header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version    = Version;
+        header.components = static_cast<std::uint32_t>(mComponents);
+        header.key        = mKey;
+        header.width      = static_cast<std::uint32_t>(mWidth);
+        header.height     = static_cast<std::uint32_t>(mHeight);
+        header.levelCount = static_cast<std::uint32_t>(mLevels);
+        std::memcpy(file.data(), & header, sizeof(header));
+
+        // Borders wrap around at the sides and repeat the edge at the poles
+        std::size_t components = static_cast<std::size_t>(mComponents);
+        unsigned char * out = file.data() + tileOffset;
+        for (int level = 0; level < mLevels; level++)
+        {
+            MipChain::Level const & source = levels[level];
+            for (int ty = 0; ty < tilesY(level); ty++)
+            for (int tx = 0; tx < tilesX(level); tx++)
+            for (int py = -Border; py < TileSize + Border; py++)
+            {
+                int sy = std::min(std::max(ty * TileSize + py, 0), source.height - 1);
+                unsigned char const * row = source.pixels + std::size_t(sy) * source.width * components;
+                for (int px = -Border; px < TileSize + Border; px++)
+                {
+                    int sx = ((tx * TileSize + px) % source.width + source.width) % source.width;
+                    std::memcpy(out, row + sx * components, components);
+                    out += components;
+                }
+            }
+        }
+        return true;
+    }
+
+    unsigned char const * TileFile::tile(int level, int x, int y) const
+    {
+        return mTiles + (mFirstTile[level] + std::size_t(y) * tilesX(level) + x) * tileBytes();
+    }
+};
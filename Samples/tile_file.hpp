@@ -0,0 +1,90 @@
+#pragma once
+
+// Local Headers
+#include "mapped_file.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // The mip levels of a large map cut into square tiles for virtual
+    // texturing (see VirtualTextures), kept in a cache file next to the map's
+    // MipChain: a header, then every tile of every level, largest level first,
+    // rows of tiles from the top. A tile holds TileSize texels square of its
+    // level plus a Border on every side copied from its neighbours, wrapping
+    // around horizontally and clamping at the poles like a map of a sphere, so
+    // that filtering inside a tile never needs another. Levels go down to the
+    // first that fits in a single tile.
+    //
+    // Only maps at least minResolution() wide, with power-of-two sides of at
+    // least TileSize, at most 256 tiles across and three or four components
+    // are tiled; the others are left to the TextureCache.
+    class TileFile
+    {
+    public:
+
+        // Bump whenever the file layout changes.
+        static const std::uint32_t Version = 1;
+
+        // Texels across a tile, and across a stored tile with its borders.
+        static const int TileSize = 128;
+        static const int Border = 4;
+        static const int Stride = TileSize + 2 * Border;
+
+        // Narrowest map that is tiled, or 0 to tile none; 4096 by default,
+        // which takes in the largest maps under Models/.
+        static void setMinResolution(int pixels);
+        static int minResolution();
+
+        // Maps the tiles of a map, cutting them from its mip chain and
+        // writing the file first if it is missing or stale. Invalid if the map
+        // is not to be tiled. Makes no GL calls.
+        explicit TileFile(std::string const & image);
+
+        bool valid() const { return mTiles != nullptr; }
+        std::string const & path() const { return mPath; }
+        int width() const { return mWidth; }
+        int height() const { return mHeight; }
+        int components() const { return mComponents; }
+        int levels() const { return mLevels; }
+
+        // Tiles across and down a level.
+        int tilesX(int level) const { return std::max(mTilesX >> level, 1); }
+        int tilesY(int level) const { return std::max(mTilesY >> level, 1); }
+
+        // Stride by Stride texels, rows tightly packed.
+        std::size_t tileBytes() const { return std::size_t(Stride) * Stride * mComponents; }
+        unsigned char const * tile(int level, int x, int y) const;
+
+    private:
+
+        // Disable Copying and Assignment
+        TileFile(TileFile const &) = delete;
+        TileFile & operator=(TileFile const &) = delete;
+
+        // Private Member Functions
+        bool open(unsigned char const * data, std::size_t size);
+        bool build(std::string const & image, std::vector<unsigned char> & file);
+        void layout(int width, int height);
+
+        // Private Member Variables
+        MappedFile mFile;
+        std::vector<unsigned char> mMemory; // used when the cache cannot be written
+        std::string mPath;
+        unsigned char const * mTiles;
+        std::vector<std::size_t> mFirstTile; // of each level, counting from the first
+        std::uint64_t mKey;
+        int mWidth;
+        int mHeight;
+        int mComponents;
+        int mLevels;
+        int mTilesX;
+        int mTilesY;
+    };
+};
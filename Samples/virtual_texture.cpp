@@ -0,0 +1,362 @@
+// Local Headers
+#include "virtual_texture.hpp"
+
+// Standard Headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Define Namespace
+namespace Mirage
+{
+    // Feedback pixels no map covers keep this map number
+    static const GLuint noMap = 255;
+
+    // Tile keys pack the map, level and tile position a byte each, which
+    // TileFile's limit of 256 tiles across allows
+    static int keyMap(std::uint32_t key)   { return static_cast<int>(key >> 24); }
+    static int keyLevel(std::uint32_t key) { return static_cast<int>((key >> 16) & 0xff); }
+    static int keyX(std::uint32_t key)     { return static_cast<int>(key & 0xff); }
+    static int keyY(std::uint32_t key)     { return static_cast<int>((key >> 8) & 0xff); }
+
+    std::uint32_t VirtualTextures::tileKey(int id, int level, int x, int y)
+    {
+        return (std::uint32_t(id) << 24) | (std::uint32_t(level) << 16) | (std::uint32_t(y) << 8) | std::uint32_t(x);
+    }
+
+    VirtualTextures::VirtualTextures(int tiles)
+        : mAtlas(TextureObject::create())
+        , mSlotsAcross(0)
+        , mFrame(1)
+        , mStats()
+        , mFramebuffer(0)
+        , mColorBuffer(0)
+        , mDepthBuffer(0)
+        , mFeedbackWidth(0)
+        , mFeedbackHeight(0)
+        , mNext(0)
+        , mSavedFramebuffer(0)
+    {
+        // A square of slots, as many as a byte can number across and the
+        // largest texture the GL takes can hold
+        GLint largest = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, & largest);
+        int most = std::min(255, static_cast<int>(largest) / TileFile::Stride);
+        while (mSlotsAcross * mSlotsAcross < tiles && mSlotsAcross < most)
+            mSlotsAcross++;
+        if (mSlotsAcross * mSlotsAcross < tiles)
+            fprintf(stderr, "Virtual texture atlas holds %d tiles of the %d asked for\n",
+                    mSlotsAcross * mSlotsAcross, tiles);
+        Slot empty = { 0, 0, false };
+        mSlots.assign(std::size_t(mSlotsAcross) * mSlotsAcross, empty);
+
+        // Bilinear within a tile; the borders keep it from reading the next
+        GLsizei side = mSlotsAcross * TileFile::Stride;
+        glBindTexture(GL_TEXTURE_2D, mAtlas.get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, side, side, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Feedback targets get their storage once the viewport is known
+        glGenFramebuffers(1, & mFramebuffer);
+        glGenRenderbuffers(1, & mColorBuffer);
+        glGenRenderbuffers(1, & mDepthBuffer);
+        for (int i = 0; i < 2; i++)
+        {
+            mPixels[i] = Buffer::create();
+            mFences[i] = nullptr;
+            mSizes[i][0] = mSizes[i][1] = 0;
+        }
+    }
+
+    VirtualTextures::~VirtualTextures()
+    {
+        for (auto fence : mFences)
+            if (fence) glDeleteSync(fence);
+        glDeleteRenderbuffers(1, & mDepthBuffer);
+        glDeleteRenderbuffers(1, & mColorBuffer);
+        glDeleteFramebuffers(1, & mFramebuffer);
+    }
+
+    int VirtualTextures::add(std::shared_ptr<TileFile> const & file)
+    {
+        for (std::size_t i = 0; i < mImages.size(); i++)
+            if (mImages[i]->file->path() == file->path())
+                return static_cast<int>(i);
+        if (!file->valid() || mImages.size() >= noMap)
+            return -1;
+        int slot = evict();
+        if (slot < 0)
+            return -1;
+
+        // Page table levels shrink with the tile levels, down to one texel
+        int id = static_cast<int>(mImages.size());
+        std::unique_ptr<Image> image(new Image);
+        image->file = file;
+        image->pageTable = TextureObject::create();
+        image->dirty = true;
+        glBindTexture(GL_TEXTURE_2D, image->pageTable.get());
+        for (int level = 0; level < file->levels(); level++)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8UI, file->tilesX(level), file->tilesY(level),
+                         0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+            image->pages.emplace_back(std::size_t(file->tilesX(level)) * file->tilesY(level) * 4, 0);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file->levels() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        Texture pages;
+        pages.name = image->pageTable.get();
+        pages.type = "virtual_pages";
+        pages.path = file->path();
+        pages.unit = Shader::textureUnit(pages.type);
+        Texture atlas;
+        atlas.name = mAtlas.get();
+        atlas.type = "virtual_atlas";
+        atlas.unit = Shader::textureUnit(atlas.type);
+        image->material.push_back(pages);
+        image->material.push_back(atlas);
+        mImages.push_back(std::move(image));
+
+        // The single tile of the smallest level stands in for every other
+        upload(slot, tileKey(id, file->levels() - 1, 0, 0));
+        mSlots[slot].pinned = true;
+        writePages(*mImages[id], id);
+        return id;
+    }
+
+    void VirtualTextures::bindFeedback(Shader & shader, int id) const
+    {
+        TileFile const & file = *mImages[id]->file;
+        shader.bind("virtualMap", id);
+        shader.bind("virtualLayout", glm::vec4(static_cast<float>(file.width()), static_cast<float>(file.height()),
+                                               static_cast<float>(file.levels()), std::log2(float(FeedbackScale))));
+    }
+
+    void VirtualTextures::beginFeedback()
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, & mSavedFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, mSavedViewport);
+        int width = std::max(1, mSavedViewport[2] / FeedbackScale);
+        int height = std::max(1, mSavedViewport[3] / FeedbackScale);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        if (width != mFeedbackWidth || height != mFeedbackHeight)
+        {
+            glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8UI, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+            mFeedbackWidth = width;
+            mFeedbackHeight = height;
+        }
+        glViewport(0, 0, width, height);
+
+        static const GLuint none[4] = { noMap, noMap, noMap, noMap };
+        static const GLfloat farthest = 1.0f;
+        glClearBufferuiv(GL_COLOR, 0, none);
+        glClearBufferfv(GL_DEPTH, 0, & farthest);
+    }
+
+    void VirtualTextures::endFeedback()
+    {
+        // Copy into a buffer now, map it a frame later
+        int index = mNext;
+        if (mFences[index])
+            glDeleteSync(mFences[index]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixels[index].get());
+        if (mSizes[index][0] != mFeedbackWidth || mSizes[index][1] != mFeedbackHeight)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, std::size_t(mFeedbackWidth) * mFeedbackHeight * 4, nullptr, GL_STREAM_READ);
+            mSizes[index][0] = mFeedbackWidth;
+            mSizes[index][1] = mFeedbackHeight;
+        }
+        glReadPixels(0, 0, mFeedbackWidth, mFeedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        mFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mNext = index ^ 1;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mSavedFramebuffer);
+        glViewport(mSavedViewport[0], mSavedViewport[1], mSavedViewport[2], mSavedViewport[3]);
+    }
+
+    void VirtualTextures::readFeedback()
+    {
+        // Only the newest feedback, and only once the GPU has written it
+        int index = mNext ^ 1;
+        GLsync & fence = mFences[index];
+        if (!fence || glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        std::size_t bytes = std::size_t(mSizes[index][0]) * mSizes[index][1] * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixels[index].get());
+        auto pixels = static_cast<GLubyte const *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+        if (pixels)
+        {
+            mRequests.clear();
+            for (std::size_t i = 0; i < bytes; i += 4)
+            {
+                GLubyte const * pixel = pixels + i;
+                if (pixel[0] >= mImages.size())
+                    continue;
+                TileFile const & file = *mImages[pixel[0]]->file;
+                if (pixel[1] >= file.levels() || pixel[2] >= file.tilesX(pixel[1]) || pixel[3] >= file.tilesY(pixel[1]))
+                    continue;
+                std::uint32_t key = tileKey(pixel[0], pixel[1], pixel[2], pixel[3]);
+                if (mRequests.empty() || mRequests.back() != key)
+                    mRequests.push_back(key);
+            }
+            std::sort(mRequests.begin(), mRequests.end());
+            mRequests.erase(std::unique(mRequests.begin(), mRequests.end()), mRequests.end());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void VirtualTextures::update()
+    {
+        mFrame++;
+        readFeedback();
+
+        // Every tile asked for, and the ancestors that stand in for it until
+        // it arrives, coarsest first; the last feedback is asked again until
+        // a newer one is read
+        std::vector<std::uint32_t> needed;
+        for (auto key : mRequests)
+        {
+            int id = keyMap(key), x = keyX(key), y = keyY(key);
+            for (int level = keyLevel(key); level < mImages[id]->file->levels(); level++, x >>= 1, y >>= 1)
+                needed.push_back(tileKey(id, level, x, y));
+        }
+        std::sort(needed.begin(), needed.end(), [](std::uint32_t a, std::uint32_t b) {
+            return keyLevel(a) != keyLevel(b) ? keyLevel(a) > keyLevel(b) : a < b;
+        });
+        needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+        // Keep what is in use from being evicted, then fill in the rest
+        std::vector<std::uint32_t> missing;
+        for (auto key : needed)
+        {
+            auto found = mResident.find(key);
+            if (found != mResident.end())
+                mSlots[found->second].used = mFrame;
+            else
+                missing.push_back(key);
+        }
+        int uploads = 0;
+        for (auto key : missing)
+        {
+            if (uploads == MaxUploads)
+                break;
+            int slot = evict();
+            if (slot < 0)
+                break;
+            upload(slot, key);
+            uploads++;
+        }
+
+        for (std::size_t id = 0; id < mImages.size(); id++)
+            if (mImages[id]->dirty)
+                writePages(*mImages[id], static_cast<int>(id));
+
+        mStats.requested = static_cast<int>(needed.size());
+        mStats.missing = static_cast<int>(missing.size());
+        mStats.uploads = uploads;
+        mStats.resident = static_cast<int>(mResident.size());
+    }
+
+    int VirtualTextures::evict()
+    {
+        // The slot asked for least recently, empty ones first, never one
+        // asked for in this update
+        int victim = -1;
+        for (std::size_t i = 0; i < mSlots.size(); i++)
+        {
+            Slot const & slot = mSlots[i];
+            if (slot.pinned || slot.used == mFrame)
+                continue;
+            if (victim < 0 || slot.used < mSlots[victim].used)
+                victim = static_cast<int>(i);
+            if (slot.used == 0)
+                break;
+        }
+        if (victim >= 0 && mSlots[victim].used != 0)
+        {
+            mResident.erase(mSlots[victim].key);
+            mImages[keyMap(mSlots[victim].key)]->dirty = true;
+        }
+        return victim;
+    }
+
+    void VirtualTextures::upload(int slot, std::uint32_t key)
+    {
+        Image & image = *mImages[keyMap(key)];
+        TileFile const & file = *image.file;
+        GLenum format = file.components() == 4 ? GL_RGBA : GL_RGB;
+        glBindTexture(GL_TEXTURE_2D, mAtlas.get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % mSlotsAcross) * TileFile::Stride, (slot / mSlotsAcross) * TileFile::Stride,
+                        TileFile::Stride, TileFile::Stride, format, GL_UNSIGNED_BYTE,
+                        file.tile(keyLevel(key), keyX(key), keyY(key)));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        Slot filled = { key, mFrame, false };
+        mSlots[slot] = filled;
+        mResident[key] = slot;
+        image.dirty = true;
+    }
+
+    void VirtualTextures::writePages(Image & image, int id)
+    {
+        // A tile that is not resident takes the entry of its parent, which
+        // was written just before; the smallest level always is resident
+        TileFile const & file = *image.file;
+        glBindTexture(GL_TEXTURE_2D, image.pageTable.get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = file.levels() - 1; level >= 0; level--)
+        {
+            int across = file.tilesX(level), down = file.tilesY(level);
+            std::vector<GLubyte> & pages = image.pages[level];
+            for (int y = 0; y < down; y++)
+            for (int x = 0; x < across; x++)
+            {
+                GLubyte * entry = & pages[(std::size_t(y) * across + x) * 4];
+                auto found = mResident.find(tileKey(id, level, x, y));
+                if (found != mResident.end())
+                {
+                    entry[0] = static_cast<GLubyte>(found->second % mSlotsAcross);
+                    entry[1] = static_cast<GLubyte>(found->second / mSlotsAcross);
+                    entry[2] = static_cast<GLubyte>(level);
+                    entry[3] = 255;
+                }
+                else if (level + 1 < file.levels())
+                {
+                    std::size_t parent = std::size_t(std::min(y >> 1, file.tilesY(level + 1) - 1)) * file.tilesX(level + 1)
+                                       + std::min(x >> 1, file.tilesX(level + 1) - 1);
+                    std::copy(& image.pages[level + 1][parent * 4], & image.pages[level + 1][parent * 4] + 4, entry);
+                }
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, across, down, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, pages.data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        image.dirty = false;
+    }
+
+    std::size_t VirtualTextures::gpuBytes() const
+    {
+        std::size_t side = std::size_t(mSlotsAcross) * TileFile::Stride;
+        std::size_t bytes = side * side * 4;
+        for (auto const & image : mImages)
+            for (auto const & pages : image->pages)
+                bytes += pages.size();
+        return bytes;
+    }
+};
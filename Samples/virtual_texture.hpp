@@ -0,0 +1,148 @@
+#pragma once
+
+// Local Headers
+#include "gl_object.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "tile_file.hpp"
+
+// System Headers
+#include <glad/glad.h>
+
+// Standard Headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Define Namespace
+namespace Mirage
+{
+    // Virtual texturing of tiled maps (see TileFile). The tiles in use live in
+    // one atlas of a fixed number of tiles shared by every map, so the memory
+    // they take is set by what is on screen, not by the size of the maps.
+    //
+    // Each map has a page table, an RGBA8UI texture with a texel per tile and
+    // a level per tile level, giving the atlas slot and level of the tile
+    // that stands in for it: the tile itself when resident, or else its
+    // nearest resident ancestor. The smallest level of every map is resident
+    // for good, so every lookup lands somewhere. Programs read maps through
+    // virtual_surface.frag, from the samplers virtual_pages and virtual_atlas.
+    //
+    // Which tiles are needed is found by a feedback pass: the virtual draws
+    // again, into a framebuffer a FeedbackScale-th of the viewport on each
+    // side, with a program that writes the map, level and tile each pixel
+    // would read. The result is read back into a buffer and used a frame
+    // later if the GPU is done with it, so the pass never waits on the GPU.
+    // Missing tiles are then streamed in from the mapped tile files, coarsest
+    // first and at most MaxUploads a frame, in place of the tiles requested
+    // least recently.
+    //
+    // Everything here belongs to the thread that owns the GL context.
+    class VirtualTextures
+    {
+    public:
+
+        // Feedback pixels are this many viewport pixels on each side.
+        static const int FeedbackScale = 8;
+
+        // Tiles uploaded by one update at most.
+        static const int MaxUploads = 16;
+
+        // What the last update found and did.
+        struct Stats
+        {
+            int requested; // tiles wanted, with the ancestors standing in for them
+            int missing;   // of those, tiles not resident before the update
+            int uploads;
+            int resident;
+        };
+
+        // Creates an atlas with room for at least the given number of tiles,
+        // or for as many as GL_MAX_TEXTURE_SIZE allows.
+        explicit VirtualTextures(int tiles = 256);
+        ~VirtualTextures();
+
+        // Registers a map and uploads its smallest level. Returns its id, or
+        // -1 if the atlas has no slot left for it. The file stays mapped while
+        // registered; registering one path twice returns the same id.
+        int add(std::shared_ptr<TileFile> const & file);
+
+        // Textures that draw a map: its page table and the atlas, on the
+        // units of virtual_pages and virtual_atlas.
+        std::vector<Texture> const & material(int id) const { return mImages[id]->material; }
+
+        // Sets the uniforms of a feedback program for drawing a map.
+        void bindFeedback(Shader & shader, int id) const;
+
+        // Surround the feedback draws. begin binds the feedback framebuffer,
+        // sized from the current viewport, and clears it; end starts reading
+        // it back and restores the framebuffer and viewport.
+        void beginFeedback();
+        void endFeedback();
+
+        // Takes in the last feedback if it is ready and uploads the missing
+        // tiles it asks for; to be called before the virtual draws.
+        void update();
+
+        std::size_t size() const { return mImages.size(); }
+        int capacity() const { return static_cast<int>(mSlots.size()); }
+        Stats const & stats() const { return mStats; }
+
+        // Bytes of the atlas and page tables on the GPU.
+        std::size_t gpuBytes() const;
+
+    private:
+
+        // Disable Copying and Assignment
+        VirtualTextures(VirtualTextures const &) = delete;
+        VirtualTextures & operator=(VirtualTextures const &) = delete;
+
+        struct Image
+        {
+            std::shared_ptr<TileFile> file;
+            TextureObject pageTable;
+            std::vector<Texture> material;
+            std::vector<std::vector<GLubyte>> pages; // RGBA8 entries of each level
+            bool dirty;
+        };
+
+        struct Slot
+        {
+            std::uint32_t key;  // tile held, see tileKey()
+            std::uint64_t used; // last update that asked for it, 0 if empty
+            bool pinned;
+        };
+
+        // Private Member Functions
+        static std::uint32_t tileKey(int id, int level, int x, int y);
+        int  evict();
+        void upload(int slot, std::uint32_t key);
+        void readFeedback();
+        void writePages(Image & image, int id);
+
+        // Private Member Variables
+        std::vector<std::unique_ptr<Image>> mImages;
+        TextureObject mAtlas;
+        int mSlotsAcross;
+        std::vector<Slot> mSlots;
+        std::unordered_map<std::uint32_t, int> mResident; // tile key to slot
+        std::vector<std::uint32_t> mRequests; // from the last feedback read
+        std::uint64_t mFrame;
+        Stats mStats;
+
+        // Feedback Framebuffer and Read Back, Double-Buffered
+        GLuint mFramebuffer;
+        GLuint mColorBuffer;
+        GLuint mDepthBuffer;
+        int mFeedbackWidth;
+        int mFeedbackHeight;
+        Buffer mPixels[2];
+        GLsync mFences[2];
+        int mSizes[2][2]; // width and height read into each buffer
+        int mNext;        // buffer the next feedback is read into
+        GLint mSavedFramebuffer;
+        GLint mSavedViewport[4];
+    };
+};